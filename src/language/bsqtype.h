@@ -11,6 +11,27 @@
 //An inline string has the length in the low 3 bits of the pointer
 #define PTR_MASK_STRING_AND_SLOT_PTR_VALUED(M, V) ((M == PTR_MASK_STRING) & (((uintptr_t)(V) & 0x7)== 0))
 
+//Compiled form of the ptr_mask -- set up by compileTypeLayout when the type is registered or first allocated (see REGISTER_TYPE)
+#define PTR_LAYOUT_UNCOMPILED 0
+#define PTR_LAYOUT_LEAF 1
+#define PTR_LAYOUT_BITMAP 2
+#define PTR_LAYOUT_OFFSETS 3
+
+//Types with more slots than this use a list of the pointer slot indices instead of bitmaps
+#define PTR_LAYOUT_BITMAP_MAX_SLOTS 64
+//Offset list entries are the slot index shifted up one with the low bit set for string slots
+#define PTR_LAYOUT_OFFSET_STRING 0x1
+
+//Generated types (see bsqtypelayout.h) carry an unrolled function that writes the address of each heap pointer slot to found and returns the count
+typedef uint32_t (*PtrSlotsFn)(void** slots, void*** found);
+#define PTR_SLOTS_FN_MAX_SLOTS 64
+
+//Load a pointer slot that a concurrent marker may read while the mutator stores to it (relaxed -- a plain load on x86, see GC_WRITE_BARRIER)
+#define PTR_LAYOUT_LOAD_SLOT(S) __atomic_load_n((S), __ATOMIC_RELAXED)
+
+//Slot holds a heap pointer -- not null and (for strings) not an inline value
+#define PTR_LAYOUT_SLOT_PTR_VALUED(V, ISSTR) (((V) != nullptr) & (!(ISSTR) | (((uintptr_t)(V) & 0x7) == 0)))
+
 struct TypeInfoBase 
 {
     uint32_t type_id;
@@ -19,4 +40,49 @@ struct TypeInfoBase
     const char* ptr_mask; //NULL is for leaf values or structs
 
     const char* typekey;
+
+    //Left out of the type definitions and filled in from ptr_mask by compileTypeLayout
+    uint32_t layout_kind = PTR_LAYOUT_UNCOMPILED;
+    uint32_t layout_count = 0; //entries in layout_offsets
+    uint64_t ptr_bits = 0; //bit i is set if slot i is a pointer or a string
+    uint64_t str_bits = 0; //bit i is set if slot i is a string
+    const uint32_t* layout_offsets = nullptr;
+    PtrSlotsFn ptr_slots_fn = nullptr;
 };
+
+//Call fn on the address of every slot in obj that holds a heap pointer (in slot order)
+template <typename F>
+inline void visitPointerSlots(const TypeInfoBase* type, void** slots, F fn) noexcept
+{
+    GC_INVARIANT_CHECK(type->layout_kind != PTR_LAYOUT_UNCOMPILED);
+
+    if(type->ptr_slots_fn != nullptr) {
+        void** found[PTR_SLOTS_FN_MAX_SLOTS];
+        uint32_t count = type->ptr_slots_fn(slots, found);
+        for(uint32_t i = 0; i < count; i++) {
+            fn(found[i]);
+        }
+    }
+    else if(type->layout_kind == PTR_LAYOUT_BITMAP) {
+        uint64_t bits = type->ptr_bits;
+        uint64_t strs = type->str_bits;
+        while(bits != 0) {
+            uint32_t i = (uint32_t)__builtin_ctzll(bits);
+            bits &= (bits - 1);
+
+            if(PTR_LAYOUT_SLOT_PTR_VALUED(PTR_LAYOUT_LOAD_SLOT(slots + i), (strs >> i) & 0x1)) {
+                fn(slots + i);
+            }
+        }
+    }
+    else if(type->layout_kind == PTR_LAYOUT_OFFSETS) {
+        const uint32_t* offsets = type->layout_offsets;
+        for(uint32_t j = 0; j < type->layout_count; j++) {
+            void** slot = slots + (offsets[j] >> 1);
+
+            if(PTR_LAYOUT_SLOT_PTR_VALUED(PTR_LAYOUT_LOAD_SLOT(slot), offsets[j] & PTR_LAYOUT_OFFSET_STRING)) {
+                fn(slot);
+            }
+        }
+    }
+}
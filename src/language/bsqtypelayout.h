@@ -0,0 +1,170 @@
+#pragma once
+
+#include "bsqtype.h"
+
+#include <type_traits>
+#include <utility>
+
+//
+//Derive a TypeInfoBase from a C++ struct and descriptors for its pointer (and string) fields at compile time
+//  -- the size, slot count, ptr_mask, and compiled layout all come from the struct so they cannot drift from it
+//  -- types with up to PTR_SLOTS_FN_MAX_SLOTS pointer fields also get an unrolled ptr_slots_fn that the collector calls through the type record
+//  -- fields that are not listed are scalars
+//
+//    TypeInfoBase TreeNodeType = BSQTypeLayout<TreeNode, BSQ_PTR_FIELD(TreeNode, left), BSQ_PTR_FIELD(TreeNode, right)>::typeInfo(1, "TreeNodeType");
+//
+
+struct BSQFieldDesc
+{
+    uint32_t slot;
+    char kind; //PTR_MASK_PTR or PTR_MASK_STRING
+};
+
+//Not constexpr so reaching it while building a layout is a compile error that names the problem
+inline void bsq_layout_error_field_is_not_one_aligned_pointer_slot() noexcept { }
+inline void bsq_layout_error_duplicate_or_out_of_range_field() noexcept { }
+
+consteval BSQFieldDesc bsqFieldDesc(size_t offset, size_t size, bool isptr, char kind) noexcept
+{
+    if((offset % sizeof(void*) != 0) | (size != sizeof(void*)) | !isptr) {
+        bsq_layout_error_field_is_not_one_aligned_pointer_slot();
+    }
+
+    return { (uint32_t)(offset / sizeof(void*)), kind };
+}
+
+#define BSQ_PTR_FIELD(T, F) bsqFieldDesc(offsetof(T, F), sizeof(T::F), std::is_pointer_v<decltype(T::F)>, PTR_MASK_PTR)
+//Strings are any slot sized value (inline strings keep their length in the low bits)
+#define BSQ_STRING_FIELD(T, F) bsqFieldDesc(offsetof(T, F), sizeof(T::F), true, PTR_MASK_STRING)
+
+template <size_t N>
+struct BSQFieldList
+{
+    BSQFieldDesc entries[N != 0 ? N : 1];
+};
+
+//Fields in slot order so generated scans visit slots in the same order as the mask based ones
+template <uint32_t SLOTS, BSQFieldDesc... Fs>
+consteval BSQFieldList<sizeof...(Fs)> bsqSortedFields() noexcept
+{
+    BSQFieldList<sizeof...(Fs)> fields = { { Fs... } };
+
+    for(size_t i = 1; i < sizeof...(Fs); i++) {
+        BSQFieldDesc fd = fields.entries[i];
+
+        size_t j = i;
+        while(j > 0 && fields.entries[j - 1].slot > fd.slot) {
+            fields.entries[j] = fields.entries[j - 1];
+            j--;
+        }
+        fields.entries[j] = fd;
+    }
+
+    for(size_t i = 0; i < sizeof...(Fs); i++) {
+        if((fields.entries[i].slot >= SLOTS) | ((i != 0) && (fields.entries[i - 1].slot == fields.entries[i].slot))) {
+            bsq_layout_error_duplicate_or_out_of_range_field();
+        }
+    }
+
+    return fields;
+}
+
+template <uint32_t SLOTS>
+struct BSQPtrMask
+{
+    char chars[SLOTS + 1];
+};
+
+template <uint32_t SLOTS, BSQFieldDesc... Fs>
+consteval BSQPtrMask<SLOTS> bsqPtrMask() noexcept
+{
+    BSQPtrMask<SLOTS> mask = {};
+    for(uint32_t i = 0; i < SLOTS; i++) {
+        mask.chars[i] = PTR_MASK_NOP;
+    }
+    ((mask.chars[Fs.slot] = Fs.kind), ...);
+    mask.chars[SLOTS] = '\0';
+
+    return mask;
+}
+
+template <size_t N>
+struct BSQOffsetList
+{
+    uint32_t entries[N != 0 ? N : 1];
+};
+
+//Offset list in the PTR_LAYOUT_OFFSETS encoding
+template <uint32_t SLOTS, BSQFieldDesc... Fs>
+consteval BSQOffsetList<sizeof...(Fs)> bsqLayoutOffsets() noexcept
+{
+    BSQFieldList<sizeof...(Fs)> fields = bsqSortedFields<SLOTS, Fs...>();
+
+    BSQOffsetList<sizeof...(Fs)> offsets = {};
+    for(size_t i = 0; i < sizeof...(Fs); i++) {
+        offsets.entries[i] = (fields.entries[i].slot << 1) | ((fields.entries[i].kind == PTR_MASK_STRING) ? PTR_LAYOUT_OFFSET_STRING : 0);
+    }
+
+    return offsets;
+}
+
+template <typename T, BSQFieldDesc... Fs>
+class BSQTypeLayout
+{
+    static_assert(sizeof(T) % sizeof(void*) == 0, "Objects must be a whole number of slots");
+
+public:
+    constexpr static uint32_t SLOT_COUNT = sizeof(T) / sizeof(void*);
+    constexpr static uint32_t FIELD_COUNT = sizeof...(Fs);
+
+    constexpr static BSQFieldList<FIELD_COUNT> s_fields = bsqSortedFields<SLOT_COUNT, Fs...>();
+    constexpr static BSQPtrMask<SLOT_COUNT> s_mask = bsqPtrMask<SLOT_COUNT, Fs...>();
+
+    constexpr static uint64_t s_ptr_bits = ((Fs.slot < PTR_LAYOUT_BITMAP_MAX_SLOTS ? (1ul << Fs.slot) : 0ul) | ... | 0ul);
+    constexpr static uint64_t s_str_bits = (((Fs.slot < PTR_LAYOUT_BITMAP_MAX_SLOTS) & (Fs.kind == PTR_MASK_STRING) ? (1ul << Fs.slot) : 0ul) | ... | 0ul);
+    constexpr static bool s_all_in_bitmap = ((Fs.slot < PTR_LAYOUT_BITMAP_MAX_SLOTS) && ... && true);
+
+    //Only wide types point into this
+    constexpr static BSQOffsetList<FIELD_COUNT> s_offsets = bsqLayoutOffsets<SLOT_COUNT, Fs...>();
+
+private:
+    //Store every candidate slot and only advance past the ones that hold heap pointers -- no branches per field
+    template <size_t... Is>
+    inline static uint32_t ptrSlotsUnrolled(void** slots, void*** found, std::index_sequence<Is...>) noexcept
+    {
+        uint32_t count = 0;
+        ((found[count] = slots + s_fields.entries[Is].slot, count += PTR_LAYOUT_SLOT_PTR_VALUED(PTR_LAYOUT_LOAD_SLOT(slots + s_fields.entries[Is].slot), s_fields.entries[Is].kind == PTR_MASK_STRING)), ...);
+
+        return count;
+    }
+
+public:
+    static uint32_t ptrSlots(void** slots, void*** found) noexcept
+    {
+        if constexpr(FIELD_COUNT == 0) {
+            return 0;
+        }
+        else {
+            return ptrSlotsUnrolled(slots, found, std::make_index_sequence<FIELD_COUNT>{});
+        }
+    }
+
+    constexpr static TypeInfoBase typeInfo(uint32_t type_id, const char* typekey) noexcept
+    {
+        uint32_t kind = (FIELD_COUNT == 0) ? PTR_LAYOUT_LEAF : (s_all_in_bitmap ? PTR_LAYOUT_BITMAP : PTR_LAYOUT_OFFSETS);
+
+        return {
+            .type_id = type_id,
+            .type_size = (uint32_t)sizeof(T),
+            .slot_size = SLOT_COUNT,
+            .ptr_mask = s_mask.chars,
+            .typekey = typekey,
+            .layout_kind = kind,
+            .layout_count = (kind == PTR_LAYOUT_OFFSETS) ? FIELD_COUNT : 0,
+            .ptr_bits = (kind == PTR_LAYOUT_BITMAP) ? s_ptr_bits : 0ul,
+            .str_bits = (kind == PTR_LAYOUT_BITMAP) ? s_str_bits : 0ul,
+            .layout_offsets = (kind == PTR_LAYOUT_OFFSETS) ? s_offsets.entries : nullptr,
+            .ptr_slots_fn = ((FIELD_COUNT != 0) & (FIELD_COUNT <= PTR_SLOTS_FN_MAX_SLOTS)) ? &BSQTypeLayout::ptrSlots : nullptr
+        };
+    }
+};
@@ -7,3 +7,9 @@
 
 #include <threads.h>
 
+#ifdef GC_INVARIANTS
+#define GC_INVARIANT_CHECK(x) assert(x)
+#else
+#define GC_INVARIANT_CHECK(x)
+#endif
+
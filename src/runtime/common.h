@@ -2,6 +2,8 @@
 
 #include "../language/bsqtype.h"
 
+#include "support/xmem.h"
+
 #include <sys/mman.h> //mmap
 
 //DEFAULT ENABLED WHILE LOTS OF DEVELOPMENT!!!!
@@ -22,66 +24,102 @@
 #define ALLOC_ADDRESS_SPAN 2147483648ul
 #endif
 
-#define PAGE_ADDR_MASK 0xFFFFFFFFFFFFF000ul
 //Make sure any allocated page is addressable by us -- larger than 2^31 and less than 2^42
 #define MIN_ALLOCATED_ADDRESS ((void*)(2147483648ul))
 #define MAX_ALLOCATED_ADDRESS ((void*)(281474976710656ul))
 
 #define BSQ_MEM_ALIGNMENT 8
-#define BSQ_BLOCK_ALLOCATION_SIZE 4096ul
 
+//Size of the pages we get from the OS -- support (XAlloc) pages are always this size
+#define BSQ_OS_PAGE_SIZE 4096ul
+#define BSQ_XALLOC_PAGE_SIZE BSQ_OS_PAGE_SIZE
 
-//
-//worst possible case where every entry has to be inserted into fwd table:
-//BSQ_BLOCK_ALLOCATION_SIZE / 8 = 512 (assumes every entry is exactly 8 bytes with no padding);
-//then BSQ_COLLECTION_THRESHOLD * (BSQ_BLOCK_ALLOCATION_SIZE / 8 ) = 524288, thus max possible
-//entries before triggering a collection 
-//
-#define BSQ_MAX_FWD_TABLE_ENTRIES 524288ul
+//GC block size is a build time choice (e.g. -DBSQ_BLOCK_ALLOCATION_SIZE_LOG2=16 for 64KB) -- 12 (4KB) by default
+#ifndef BSQ_BLOCK_ALLOCATION_SIZE_LOG2
+#define BSQ_BLOCK_ALLOCATION_SIZE_LOG2 12
+#endif
+
+#if BSQ_BLOCK_ALLOCATION_SIZE_LOG2 < 12 || BSQ_BLOCK_ALLOCATION_SIZE_LOG2 > 21
+#error "GC block size must be between 4KB and 2MB"
+#endif
+
+#define BSQ_BLOCK_ALLOCATION_SIZE (1ul << BSQ_BLOCK_ALLOCATION_SIZE_LOG2)
+#define PAGE_ADDR_MASK (~(BSQ_BLOCK_ALLOCATION_SIZE - 1ul))
+
+//2MB blocks line up with x86-64 huge pages so ask for transparent huge page backing
+#if BSQ_BLOCK_ALLOCATION_SIZE_LOG2 == 21
+#define BSQ_BLOCK_USE_THP
+#endif
+
+//GC pages are carved out of large reserved (PROT_NONE) regions of address space that are committed a slab at a time
+#define BSQ_GC_RESERVATION_SIZE (1024ul * 1024ul * 1024ul)
+#define BSQ_GC_COMMIT_SLAB_SIZE (64ul * BSQ_BLOCK_ALLOCATION_SIZE)
+
+//Empty GC pages past the first BSQ_DECOMMIT_MIN_POOL_PAGES that have been empty for BSQ_DECOMMIT_MIN_AGE_MS are given back to the OS
+#define BSQ_DECOMMIT_MIN_POOL_PAGES (BSQ_COLLECTION_THRESHOLD_BYTES / BSQ_BLOCK_ALLOCATION_SIZE)
+#define BSQ_DECOMMIT_MIN_AGE_MS 250ul
+#define BSQ_DECOMMIT_BATCH_SIZE 64ul
+
+//Each thread keeps a small magazine of empty pages (~256KB but at least 4 blocks) and refills/drains it from the global pool half at a time
+#define BSQ_PAGE_CACHE_CAPACITY (((256ul * 1024ul) / BSQ_BLOCK_ALLOCATION_SIZE) < 4ul ? 4ul : ((256ul * 1024ul) / BSQ_BLOCK_ALLOCATION_SIZE))
+#define BSQ_PAGE_CACHE_BATCH (BSQ_PAGE_CACHE_CAPACITY / 2ul)
+
+//Old space compaction (when enabled) evacuates the pages of a size class that are at most BSQ_COMPACTION_SPARSE_BUCKETS 5% steps full 
+//once that would free at least BSQ_COMPACTION_MIN_RECLAIM_PAGES pages -- at most BSQ_COMPACTION_MAX_BYTES of objects are moved per collection
+#define BSQ_COMPACTION_SPARSE_BUCKETS 6
+#define BSQ_COMPACTION_MIN_RECLAIM_PAGES 4ul
+#define BSQ_COMPACTION_MAX_BYTES (BSQ_COLLECTION_THRESHOLD_BYTES / 4ul)
+
+//Number of bytes of fresh allocation (filled pages) we do before we start collecting
+#define BSQ_COLLECTION_THRESHOLD_BYTES (1024ul * 4096ul)
+
+//Number of allocation pages we fill up before we start collecting
+#define BSQ_COLLECTION_THRESHOLD (BSQ_COLLECTION_THRESHOLD_BYTES / BSQ_BLOCK_ALLOCATION_SIZE)
 
 #define BSQ_MAX_ROOTS 2048ul
 #define BSQ_MAX_ALLOC_SLOTS 64ul
 
-//Number of allocation pages we fill up before we start collecting
-#define BSQ_COLLECTION_THRESHOLD 1024
+//Max GC threads (including the collecting thread) for parallel marking and evacuation
+#define BSQ_MAX_MARK_WORKERS 16ul
+
+//Marked objects a parallel evacuation worker claims at a time
+#define BSQ_EVAC_CHUNK_OBJECTS 256ul
+
+//With incremental marking on a mark cycle starts once this many bytes have been allocated (see getNewlyAllocatedBytes) and every page filled after that runs one slice
+//that scans at most the slice object budget (default BSQ_INCREMENTAL_MARK_SLICE_OBJECTS) -- the collection at BSQ_COLLECTION_THRESHOLD_BYTES finishes it
+#define BSQ_INCREMENTAL_MARK_START_BYTES (BSQ_COLLECTION_THRESHOLD_BYTES / 2ul)
+#define BSQ_INCREMENTAL_MARK_SLICE_OBJECTS 2048ul
+
+//How many child pointers the mark, evacuation and decrement loops hold (with their headers prefetched) before touching them -- a build time choice (e.g. -DBSQ_GC_PREFETCH_DISTANCE=0 to turn prefetching off)
+#ifndef BSQ_GC_PREFETCH_DISTANCE
+#define BSQ_GC_PREFETCH_DISTANCE 8ul
+#endif
 
 //Max number of decrement ops we do per collection -- 
 //    TODO:we may need to make this a bit dynamic 
-#define BSQ_INITIAL_MAX_DECREMENT_COUNT (BSQ_COLLECTION_THRESHOLD * BSQ_BLOCK_ALLOCATION_SIZE) / (BSQ_MEM_ALIGNMENT * 32)
+#define BSQ_INITIAL_MAX_DECREMENT_COUNT (BSQ_COLLECTION_THRESHOLD_BYTES) / (BSQ_MEM_ALIGNMENT * 32)
 
 //mem is an 8byte aligned pointer and n is the number of 8byte words to clear
 inline void xmem_zerofill(void* mem, size_t n) noexcept
 {
-    void** obj = (void**)mem;
-    void** end = obj + n;
-    while(obj < end) {
-        *obj = nullptr;
-        obj++;
-    }
+    xmem_zerofill_scalar(mem, n);
 }
 
-//Clears a page of memory
+//Clears a (support) page of memory
 inline void xmem_zerofillpage(void* mem) noexcept
 {
-    void** obj = (void**)mem;
-    void** end = obj + (BSQ_BLOCK_ALLOCATION_SIZE / sizeof(void*));
-    while(obj < end) {
-        *obj = nullptr;
-        obj++;
-    }
+    xmem_zerofill_scalar(mem, BSQ_XALLOC_PAGE_SIZE / sizeof(void*));
 }
 
-//mem is an 8byte aligned pointer and n is the number of 8byte words to clear
+//mem is an 8byte aligned pointer and n is the number of 8byte words to copy -- object copies (n is the slot_size) are mostly small
 inline void xmem_copy(void* memsrc, void* memtrgt, size_t n) noexcept
 {
-    void** objsrc = (void**)memsrc;
-    void** objend = objsrc + n;
-    void** objtrgt = (void**)memtrgt;
-    while(objsrc < objend) {
-        *objtrgt = *objsrc;
-        objsrc++;
-        objtrgt++;
+    if(n <= XMEM_SMALL_COPY_WORDS) [[likely]] {
+        xmem_copy_small(memsrc, memtrgt, n);
+        return;
     }
+
+    xmem_copy_scalar(memsrc, memtrgt, n);
 }
 
 //A global mutex lock that all threads will use when accessing shared page lists 
@@ -121,19 +159,20 @@ public:
 //A handy stack allocation macro
 #define BSQ_STACK_ALLOC(SIZE) ((SIZE) == 0 ? nullptr : alloca(SIZE))
 
-#define MAX_FWD_INDEX UINT32_MAX
-
 #ifdef VERBOSE_HEADER
 struct MetaData 
 {
     //!!!! alloc info is valid even when this is in a free-list so we need to make sure it does not collide with the free-list data !!!!
-    TypeInfoBase* type;
+    union {
+        TypeInfoBase* type;
+        void* forward; //new address of an evacuated (or compacted) object -- only valid when isforwarded is set
+    };
     bool isalloc;
     bool isyoung;
     bool ismarked;
     bool isroot;
+    bool isforwarded;
     //TODO -- also a parent thread root bit (that we don't clear but we treat as a root for the purposes of marking etc.)
-    uint32_t forward_index;
     uint32_t ref_count;
 }; 
 #else
@@ -145,29 +184,59 @@ typedef struct MetaData
 static_assert(sizeof(MetaData) == 8, "MetaData size is not 8 bytes");
 #endif
 
-// After we evacuate an object we need to update the original metadata
-#define RESET_METADATA_FOR_OBJECT(M, FP) *M = { .type=nullptr, .isalloc=false, .isyoung=false, .ismarked=false, .isroot=false, .forward_index=(FP), .ref_count=0 }
+#define RESET_METADATA_FOR_OBJECT(M) *M = { .type=nullptr, .isalloc=false, .isyoung=false, .ismarked=false, .isroot=false, .isforwarded=false, .ref_count=0 }
+
+// After we evacuate an object the dead header holds the new address (until the slot is rebuilt into a free-list)
+#define FORWARD_METADATA_FOR_OBJECT(M, NEWOBJ) *M = { .forward=(NEWOBJ), .isalloc=false, .isyoung=false, .ismarked=false, .isroot=false, .isforwarded=true, .ref_count=0 }
 
 #define GC_GET_META_DATA_ADDR(O) ((MetaData*)((uint8_t*)O - sizeof(MetaData)))
 
-#define GC_IS_MARKED(O) (GC_GET_META_DATA_ADDR(O))->ismarked
 #define GC_IS_YOUNG(O) (GC_GET_META_DATA_ADDR(O))->isyoung
 #define GC_IS_ALLOCATED(O) (GC_GET_META_DATA_ADDR(O))->isalloc
-#define GC_IS_ROOT(O) (GC_GET_META_DATA_ADDR(O))->isroot
-#define GC_FWD_INDEX(O) (GC_GET_META_DATA_ADDR(O))->forward_index
+#define GC_IS_FORWARDED(O) (GC_GET_META_DATA_ADDR(O))->isforwarded
+#define GC_FORWARD_PTR(O) (GC_GET_META_DATA_ADDR(O))->forward
 #define GC_REF_COUNT(O) (GC_GET_META_DATA_ADDR(O))->ref_count
 #define GC_TYPE(O) (GC_GET_META_DATA_ADDR(O))->type
 
-#define GC_SHOULD_VISIT(META) ((META)->isyoung && !(META)->ismarked)
+#define GC_SHOULD_PROCESS_AS_YOUNG(META) ((META)->isyoung)
+#define GC_CLEAR_YOUNG_MARK(META) { (META)->isyoung = false; }
 
+//
+//Build with -DBSQ_GC_MARK_BITMAP to keep the mark and root bits of size class objects in per page side bitmaps (see PageInfo in allocator.h)
+//  -- marking touches the dense bitmap words instead of a header line per object and the marks of a page are cleared with one fill when it is rebuilt
+//  -- large objects are alone in their span so they keep using the header bits
+//
+#ifndef BSQ_GC_MARK_BITMAP
+#define GC_IS_MARKED(O) (GC_GET_META_DATA_ADDR(O))->ismarked
+#define GC_IS_ROOT(O) (GC_GET_META_DATA_ADDR(O))->isroot
+
+#define GC_SHOULD_VISIT(META) ((META)->isyoung && !(META)->ismarked)
 #define GC_SHOULD_PROCESS_AS_ROOT(META) ((META)->isalloc && !(META)->isroot)
-#define GC_SHOULD_PROCESS_AS_YOUNG(META) ((META)->isyoung)
 
 #define GC_MARK_AS_ROOT(META) { (META)->isroot = true; }
 #define GC_MARK_AS_MARKED(META) { (META)->ismarked = true; }
+//Parallel marking -- true if this thread set the mark (the plain load skips the locked exchange for objects that are already marked)
+#define GC_TRY_MARK_ATOMIC(META) (!__atomic_load_n(&(META)->ismarked, __ATOMIC_RELAXED) && !__atomic_exchange_n(&(META)->ismarked, true, __ATOMIC_RELAXED))
 
-#define GC_CLEAR_YOUNG_MARK(META) { (META)->isyoung = false; }
+#define GC_CLEAR_MARK(META) { (META)->ismarked = false; }
 #define GC_CLEAR_ROOT_MARK(META) { (META)->ismarked = false; (META)->isroot = false; }
+#else
+#define GC_META_OBJ(META) ((void*)((uint8_t*)(META) + sizeof(MetaData)))
+
+#define GC_IS_MARKED(O) gcSideBitsIsMarked(O)
+#define GC_IS_ROOT(O) gcSideBitsIsRoot(O)
+
+#define GC_SHOULD_VISIT(META) ((META)->isyoung && !gcSideBitsIsMarked(GC_META_OBJ(META)))
+#define GC_SHOULD_PROCESS_AS_ROOT(META) ((META)->isalloc && !gcSideBitsIsRoot(GC_META_OBJ(META)))
+
+#define GC_MARK_AS_ROOT(META) { gcSideBitsSetRoot(GC_META_OBJ(META)); }
+#define GC_MARK_AS_MARKED(META) { gcSideBitsSetMarked(GC_META_OBJ(META)); }
+#define GC_TRY_MARK_ATOMIC(META) gcSideBitsTryMarkAtomic(GC_META_OBJ(META))
+
+#define GC_CLEAR_MARK(META) { gcSideBitsClearMarked(GC_META_OBJ(META)); }
+#define GC_CLEAR_ROOT_MARK(META) { gcSideBitsClearRootMark(GC_META_OBJ(META)); }
+#endif
 
-#define GC_SHOULD_FREE_LIST_ADD(META) (!(META)->isalloc || ((META)->ref_count == 0 && !(META)->isroot) || (!(META)->isroot && !(META)->ismarked))
+//Once the young objects are processed every survivor was evacuated or promoted so anything still young is dead -- old objects are only freed by their ref counts
+#define GC_SHOULD_FREE_LIST_ADD(META) (!(META)->isalloc || (META)->isyoung)
 
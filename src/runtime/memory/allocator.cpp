@@ -10,144 +10,560 @@ PageInfo* PageInfo::initialize(void* block, uint16_t allocsize, uint16_t realsiz
     pp->freelist = nullptr;
     pp->next = nullptr;
 
-    pp->data = ((uint8_t*)block + sizeof(PageInfo));
+#ifdef BSQ_GC_ALLOC_BITMAP
+    pp->bitmapwords = PageInfo::computeBitmapWords(realsize);
+    xmem_zerofill(pp->getYoungBits(), 2 * pp->bitmapwords);
+#endif
+#ifdef BSQ_GC_MARK_BITMAP
+    pp->markwords = PageInfo::computeBitmapWords(realsize);
+    xmem_zerofill(pp->getMarkBits(), 2 * pp->markwords);
+#endif
+
+    pp->data = ((uint8_t*)block + PageInfo::computeDataOffset(realsize));
     pp->allocsize = allocsize;
     pp->realsize = realsize;
     pp->pending_decs_count = 0;
-    pp->approx_utilization = 100.0f; // Approx util has not been calculated
-    pp->left = nullptr;
-    pp->right = nullptr;
-    pp->entrycount = (BSQ_BLOCK_ALLOCATION_SIZE - (pp->data - (uint8_t*)pp)) / realsize;
+    pp->prev = nullptr;
+    pp->pageset = PAGE_SET_NONE;
+    pp->utilclass = PAGE_UTIL_CLASS_UNSET;
+    pp->indecremented = false;
+    pp->entrycount = PageInfo::computeEntryCount(realsize);
     pp->freecount = pp->entrycount;
+    pp->spansize = 0;
+    pp->empty_timestamp = 0;
 
-    for(int64_t i = pp->entrycount - 1; i >= 0; i--) {
-        FreeListEntry* entry = pp->getFreelistEntryAtIndex(i);
-        entry->next = pp->freelist;
-        pp->freelist = entry;
-    }
+    //Fresh pages are handed out front-to-back by bumping -- no freelist is built until the page is rebuilt after a collection
+    pp->bumpptr = pp->data;
+
+    return pp;
+}
+
+PageInfo* PageInfo::initializeLargeObjectSpan(void* block, size_t spansize, size_t objsize) noexcept
+{
+    PageInfo* pp = (PageInfo*)block;
+
+    pp->freelist = nullptr;
+    pp->next = nullptr;
+
+    pp->data = ((uint8_t*)block + sizeof(PageInfo));
+    pp->allocsize = 0; //sizes do not fit -- use the type info of the object instead
+    pp->realsize = 0;
+    pp->pending_decs_count = 0;
+    pp->prev = nullptr;
+    pp->pageset = PAGE_SET_NONE;
+    pp->utilclass = PAGE_UTIL_CLASS_FULL;
+    pp->indecremented = false;
+    pp->entrycount = 1;
+    pp->freecount = 0;
+    pp->spansize = spansize;
+    pp->empty_timestamp = 0;
+    ALLOC_BITMAP_OP(pp->bitmapwords = 0);
+    MARK_BITMAP_OP(pp->markwords = 0);
+
+    pp->bumpptr = pp->data + REAL_ENTRY_SIZE(objsize);
 
     return pp;
 }
 
 void PageInfo::rebuild() noexcept
 {
+    //Marks only matter during a collection -- the surviving young objects here were evacuated or are pinned roots (whose marks are cleared with the root bits)
+    MARK_BITMAP_OP(this->clearMarkBits());
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+    //Every young object here was evacuated, promoted (and moved to the old bits), or is dead so only the old bits are still in use
+    uint64_t* young = this->getYoungBits();
+    const uint64_t* old = this->getOldBits();
+
+    uint32_t inuse = 0;
+    for(uint32_t w = 0; w < this->bitmapwords; w++) {
+        young[w] = 0;
+        inuse += (uint32_t)__builtin_popcountl(old[w]);
+    }
+
     this->freelist = nullptr;
-    this->freecount = 0;
+    this->freecount = this->entrycount - inuse;
+#else
+    //Only slots below the bump pointer have valid metadata, everything above it is still free
+    int64_t bumpidx = (int64_t)this->getBumpIndex();
+
+    this->freelist = nullptr;
+    this->freecount = this->entrycount - bumpidx;
     
-    for(int64_t i = this->entrycount - 1; i >= 0; i--) {
+    for(int64_t i = bumpidx - 1; i >= 0; i--) {
         MetaData* meta = this->getMetaEntryAtIndex(i);
         
         if(GC_SHOULD_FREE_LIST_ADD(meta)) {
             // Just to be safe reset metadata
-            RESET_METADATA_FOR_OBJECT(meta, MAX_FWD_INDEX);
+            RESET_METADATA_FOR_OBJECT(meta);
             FreeListEntry* entry = this->getFreelistEntryAtIndex(i);
             entry->next = this->freelist;
             this->freelist = entry;
             this->freecount++;
         }
     }
+#endif
 
     this->next = nullptr;
 }
 
-GlobalPageGCManager GlobalPageGCManager::g_gc_page_manager;
+//Bump space for the slot offset lists of wide types (types live forever so their layouts are never freed)
+static uint8_t* s_layout_arena_pos = nullptr;
+static uint8_t* s_layout_arena_end = nullptr;
+
+static uint32_t* allocateLayoutOffsets(size_t count) noexcept
+{
+    size_t bytes = count * sizeof(uint32_t);
+    if(bytes > BSQ_XALLOC_PAGE_SIZE) {
+        //Too big for a support page so it gets a mapping of its own
+        void* offsets = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+        assert(offsets != MAP_FAILED);
+
+        return (uint32_t*)offsets;
+    }
+
+    if((size_t)(s_layout_arena_end - s_layout_arena_pos) < bytes) {
+        s_layout_arena_pos = (uint8_t*)XAllocPageManager::g_page_manager.allocatePage();
+        s_layout_arena_end = s_layout_arena_pos + BSQ_XALLOC_PAGE_SIZE;
+    }
 
-PageInfo* GlobalPageGCManager::allocateFreshPage(uint16_t entrysize, uint16_t realsize) noexcept
+    uint32_t* offsets = (uint32_t*)s_layout_arena_pos;
+    s_layout_arena_pos += bytes;
+
+    return offsets;
+}
+
+void compileTypeLayout(TypeInfoBase* type) noexcept
 {
     GC_MEM_LOCK_ACQUIRE();
 
-    PageInfo* pp = nullptr;
-    if(this->empty_pages != nullptr) {
-        void* page = this->empty_pages;
-        this->empty_pages = this->empty_pages->next;
+    //Another thread may have compiled it while we waited on the lock
+    if(type->layout_kind == PTR_LAYOUT_UNCOMPILED) {
+        uint32_t count = 0;
+        uint32_t maxslot = 0;
+        uint64_t ptrbits = 0;
+        uint64_t strbits = 0;
+
+        if(type->ptr_mask != LEAF_PTR_MASK) {
+            for(uint32_t i = 0; type->ptr_mask[i] != '\0'; i++) {
+                char mask = type->ptr_mask[i];
+                if(mask == PTR_MASK_NOP) {
+                    continue;
+                }
+
+                count++;
+                maxslot = i;
+                if(i < PTR_LAYOUT_BITMAP_MAX_SLOTS) {
+                    ptrbits |= (1ul << i);
+                    strbits |= (mask == PTR_MASK_STRING) ? (1ul << i) : 0ul;
+                }
+            }
+        }
 
-        pp = PageInfo::initialize(page, entrysize, realsize);
-        gtl_info.total_empty_gc_pages--;
+        uint32_t kind;
+        if(count == 0) {
+            kind = PTR_LAYOUT_LEAF;
+        }
+        else if(maxslot < PTR_LAYOUT_BITMAP_MAX_SLOTS) {
+            //Wide types whose pointers are all in the first 64 slots still get the bitmap
+            kind = PTR_LAYOUT_BITMAP;
+            type->ptr_bits = ptrbits;
+            type->str_bits = strbits;
+        }
+        else {
+            kind = PTR_LAYOUT_OFFSETS;
+            uint32_t* offsets = allocateLayoutOffsets(count);
+
+            uint32_t j = 0;
+            for(uint32_t i = 0; type->ptr_mask[i] != '\0'; i++) {
+                char mask = type->ptr_mask[i];
+                if(mask != PTR_MASK_NOP) {
+                    offsets[j++] = (i << 1) | ((mask == PTR_MASK_STRING) ? PTR_LAYOUT_OFFSET_STRING : 0);
+                }
+            }
+
+            type->layout_offsets = offsets;
+            type->layout_count = count;
+        }
+
+        __atomic_store_n(&type->layout_kind, kind, __ATOMIC_RELEASE);
     }
-    else {
+
+    GC_MEM_LOCK_RELEASE();
+}
+
+GlobalPageGCManager GlobalPageGCManager::g_gc_page_manager;
+
+//Map bytes (a multiple of the OS page size) starting at a GC block aligned address -- if reserveonly the range is PROT_NONE until committed
+static void* mapGCBlocks(size_t bytes, bool reserveonly) noexcept
+{
+    int prot = reserveonly ? PROT_NONE : (PROT_READ | PROT_WRITE);
+    int flags = reserveonly ? (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE) : (MAP_PRIVATE | MAP_ANONYMOUS);
+
 #ifndef ALLOC_DEBUG_MEM_DETERMINISTIC
-        void* page = mmap(NULL, BSQ_BLOCK_ALLOCATION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+    //mmap only gives us OS page alignment so over map and trim down to an aligned block range
+    size_t mapsize = bytes + (BSQ_BLOCK_ALLOCATION_SIZE - BSQ_OS_PAGE_SIZE);
+    uint8_t* base = (uint8_t*)mmap(NULL, mapsize, prot, flags, 0, 0);
+    assert(base != MAP_FAILED);
+
+    uint8_t* page = (uint8_t*)(((uintptr_t)base + (BSQ_BLOCK_ALLOCATION_SIZE - 1)) & PAGE_ADDR_MASK);
+    if(page != base) {
+        munmap(base, page - base);
+    }
+    if(page + bytes != base + mapsize) {
+        munmap(page + bytes, (base + mapsize) - (page + bytes));
+    }
 #else
-        ALLOC_LOCK_ACQUIRE();
+    ALLOC_LOCK_ACQUIRE();
+
+    //support pages are smaller than GC blocks so realign the shared address cursor
+    uintptr_t aligned = ((uintptr_t)GlobalThreadAllocInfo::s_current_page_address + (BSQ_BLOCK_ALLOCATION_SIZE - 1)) & PAGE_ADDR_MASK;
+
+    void* page = (XAllocPage*)mmap((void*)aligned, bytes, prot, flags | MAP_FIXED, 0, 0);
+    GlobalThreadAllocInfo::s_current_page_address = (void*)(aligned + bytes);
+
+    ALLOC_LOCK_RELEASE();    
+
+    assert(page != MAP_FAILED);
+#endif
+
+#ifdef BSQ_BLOCK_USE_THP
+    if(!reserveonly) {
+        madvise(page, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return page;
+}
+
+void GlobalPageGCManager::commitSlab() noexcept
+{
+    if(this->commit_end == this->reserve_end) {
+        //The rest of the old reservation (if any) is fully committed already so just start a new one
+        uint8_t* region = (uint8_t*)mapGCBlocks(BSQ_GC_RESERVATION_SIZE, true);
+
+        this->commit_cursor = region;
+        this->commit_end = region;
+        this->reserve_end = region + BSQ_GC_RESERVATION_SIZE;
+    }
 
-        void* page = (XAllocPage*)mmap(GlobalThreadAllocInfo::s_current_page_address, BSQ_BLOCK_ALLOCATION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, 0, 0);
-        GlobalThreadAllocInfo::s_current_page_address = (void*)((uint8_t*)GlobalThreadAllocInfo::s_current_page_address + BSQ_BLOCK_ALLOCATION_SIZE);
+    if(mprotect(this->commit_end, BSQ_GC_COMMIT_SLAB_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        assert(false);
+    }
 
-        ALLOC_LOCK_RELEASE();    
+#ifdef BSQ_BLOCK_USE_THP
+    madvise(this->commit_end, BSQ_GC_COMMIT_SLAB_SIZE, MADV_HUGEPAGE);
 #endif
 
-        assert(page != MAP_FAILED);
-        this->pagetable.pagetable_insert(page);
+    this->commit_end += BSQ_GC_COMMIT_SLAB_SIZE;
+}
+
+PageInfo* GlobalPageGCManager::allocateLargeObjectSpan(size_t objsize) noexcept
+{
+    size_t spansize = GlobalPageGCManager::computeLargeObjectSpanSize(objsize);
+
+    void* span = mapGCBlocks(spansize, false);
+
+    GC_MEM_LOCK_ACQUIRE();
+
+    //Every block of the span points back to the head so interior pointers resolve to the object
+    for(size_t offset = 0; offset < spansize; offset += BSQ_BLOCK_ALLOCATION_SIZE) {
+        this->pagetable.pagetable_insert((uint8_t*)span + offset, span);
+    }
+
+    GC_MEM_LOCK_RELEASE();
+
+    return PageInfo::initializeLargeObjectSpan(span, spansize, objsize);
+}
+
+void GlobalPageGCManager::releaseLargeObjectSpan(PageInfo* span) noexcept
+{
+    size_t spansize = span->spansize;
+
+    GC_MEM_LOCK_ACQUIRE();
+
+    for(size_t offset = 0; offset < spansize; offset += BSQ_BLOCK_ALLOCATION_SIZE) {
+        this->pagetable.pagetable_remove((uint8_t*)span + offset);
+    }
+
+    GC_MEM_LOCK_RELEASE();
+
+    munmap(span, spansize);
+}
+
+void GlobalPageGCManager::refillPageCache(BSQMemoryTheadLocalInfo& owner) noexcept
+{
+    GCPageCache& cache = owner.page_cache;
+
+    size_t popped = 0;
+    PageInfo* chain = this->empty_pages.popBatch(BSQ_PAGE_CACHE_BATCH - cache.count, popped);
+    while(chain != nullptr) {
+        cache.pages[cache.count++] = chain;
+        chain = chain->next;
+    }
 
-        pp = PageInfo::initialize(page, entrysize, realsize);
-        gtl_info.total_gc_pages++;
+    if(cache.count == BSQ_PAGE_CACHE_BATCH) {
+        return;
+    }
+
+    GC_MEM_LOCK_ACQUIRE();
+
+    while(cache.count < BSQ_PAGE_CACHE_BATCH) {
+        void* page = nullptr;
+        if(this->decommitted_count != 0) {
+            //Still in the pagetable -- writing the header faults the memory back in
+            page = this->decommitted_pages.pop_back();
+            this->decommitted_count--;
+        }
+        else {
+            page = this->getFreshBlock();
+            this->pagetable.pagetable_insert(page);
+
+            owner.total_gc_pages++;
+            owner.total_empty_gc_pages++;
+        }
+
+        cache.pages[cache.count++] = (PageInfo*)page;
     }
 
     GC_MEM_LOCK_RELEASE();
+}
+
+void GlobalPageGCManager::drainPageCache(GCPageCache& cache, size_t keep) noexcept
+{
+    //The bottom of the cache stack has been empty the longest so that is what goes back to the global pool
+    size_t drain = cache.count - keep;
+    if(drain == 0) {
+        return;
+    }
+
+    for(size_t i = 0; i < drain - 1; i++) {
+        cache.pages[i]->next = cache.pages[i + 1];
+    }
+    this->empty_pages.pushBatch(cache.pages[0], cache.pages[drain - 1]);
+
+    for(size_t i = 0; i < keep; i++) {
+        cache.pages[i] = cache.pages[drain + i];
+    }
+    cache.count = keep;
+}
+
+PageInfo* GlobalPageGCManager::allocateFreshPage(BSQMemoryTheadLocalInfo& owner, uint16_t entrysize, uint16_t realsize) noexcept
+{
+    GCPageCache& cache = owner.page_cache;
+    if(cache.count == 0) [[unlikely]] {
+        this->refillPageCache(owner);
+    }
+
+    PageInfo* pp = PageInfo::initialize(cache.pages[--cache.count], entrysize, realsize);
+    owner.total_empty_gc_pages--;
+
     return pp;
 }
 
-void GCAllocator::processPage(PageInfo* p) noexcept
+void GlobalPageGCManager::addNewPage(BSQMemoryTheadLocalInfo& owner, PageInfo* newPage) noexcept
 {
-    float old_util = p->approx_utilization;
-    float n_util = CALC_APPROX_UTILIZATION(p);
-    p->approx_utilization = n_util;
-    int bucket_index = 0;
+    GCPageCache& cache = owner.page_cache;
+    if(cache.count == BSQ_PAGE_CACHE_CAPACITY) [[unlikely]] {
+        this->drainPageCache(cache, BSQ_PAGE_CACHE_BATCH);
+    }
 
-    if(p->entrycount == p->freecount) {
-        GlobalPageGCManager::g_gc_page_manager.addNewPage(p);
-        gtl_info.total_empty_gc_pages++;
+    newPage->empty_timestamp = getDecommitClockMS();
+    cache.pages[cache.count++] = newPage;
+}
+
+void GlobalPageGCManager::flushPageCache(BSQMemoryTheadLocalInfo& owner) noexcept
+{
+    this->drainPageCache(owner.page_cache, 0);
+}
+
+void GlobalPageGCManager::setDecommitPolicy(const GCDecommitPolicy& policy) noexcept
+{
+    if(this->isBackgroundDecommitEnabled()) {
+        this->decommit_thread_running.store(false, std::memory_order_release);
+        assert(thrd_join(this->decommit_thread, NULL) == thrd_success);
+    }
+
+    GC_MEM_LOCK_ACQUIRE();
+    this->decommit_policy = policy;
+    GC_MEM_LOCK_RELEASE();
+
+    if(policy.background_interval_ms != 0) {
+        this->decommit_thread_running.store(true, std::memory_order_release);
+        assert(thrd_create(&this->decommit_thread, GlobalPageGCManager::decommitThreadMain, this) == thrd_success);
+    }
+}
+
+int GlobalPageGCManager::decommitThreadMain(void* arg) noexcept
+{
+    GlobalPageGCManager* mgr = (GlobalPageGCManager*)arg;
+
+    uint64_t interval = mgr->decommit_policy.background_interval_ms;
+    struct timespec ts = { .tv_sec = (time_t)(interval / 1000ul), .tv_nsec = (long)((interval % 1000ul) * 1000000ul) };
+
+    while(mgr->decommit_thread_running.load(std::memory_order_acquire)) {
+        thrd_sleep(&ts, NULL);
+        mgr->decommitColdPages();
+    }
+
+    return 0;
+}
+
+size_t GlobalPageGCManager::decommitColdPages() noexcept
+{
+    uint64_t now = getDecommitClockMS();
+    PageInfo* cold = nullptr;
+
+    GC_MEM_LOCK_ACQUIRE();
+
+    GCDecommitPolicy policy = this->decommit_policy;
+    if(!this->decommitted_pages_init) {
+        this->decommitted_pages.initialize();
+        this->decommitted_pages_init = true;
+    }
+
+    GC_MEM_LOCK_RELEASE();
+
+    //Take the whole pool, split off the cold pages, and push the rest back -- threads that refill in between just see a shorter pool
+    //Pages are pushed on the front so the most recently emptied (hot) pages are the prefix we keep
+    PageInfo* keepfirst = nullptr;
+    PageInfo* keeplast = nullptr;
+    size_t kept = 0;
+
+    PageInfo* cur = this->empty_pages.popAll();
+    while(cur != nullptr) {
+        PageInfo* next = cur->next;
+        if(kept < policy.min_pool_pages || (now - cur->empty_timestamp) < policy.min_age_ms) {
+            cur->next = nullptr;
+            if(keeplast == nullptr) {
+                keepfirst = cur;
+            }
+            else {
+                keeplast->next = cur;
+            }
+            keeplast = cur;
+            kept++;
+        }
+        else {
+            cur->next = cold;
+            cold = cur;
+        }
+        cur = next;
+    }
+
+    if(keepfirst != nullptr) {
+        this->empty_pages.pushBatch(keepfirst, keeplast);
+    }
+
+#ifdef MADV_FREE
+    int advice = policy.lazy_free ? MADV_FREE : MADV_DONTNEED;
+#else
+    int advice = MADV_DONTNEED;
+#endif
+
+    //The madvise calls are done outside the lock and the pages are published in batches
+    void* batch[BSQ_DECOMMIT_BATCH_SIZE];
+    size_t batchcount = 0;
+    size_t total = 0;
+    while(cold != nullptr) {
+        PageInfo* next = cold->next;
+
+        //Clear the header first so a conservative scan never sees stale data if MADV_FREE leaves the memory in place
+        xmem_zerofill(cold, sizeof(PageInfo) / 8);
+        if(madvise(cold, BSQ_BLOCK_ALLOCATION_SIZE, advice) != 0) {
+            assert(false);
+        }
+        batch[batchcount++] = cold;
+
+        if(batchcount == BSQ_DECOMMIT_BATCH_SIZE || next == nullptr) {
+            GC_MEM_LOCK_ACQUIRE();
+            for(size_t i = 0; i < batchcount; i++) {
+                this->decommitted_pages.push_back(batch[i]);
+            }
+            this->decommitted_count += batchcount;
+            GC_MEM_LOCK_RELEASE();
+
+            total += batchcount;
+            batchcount = 0;
+        }
+
+        cold = next;
     }
-    else if(IS_LOW_UTIL(n_util)) {
-        GET_BUCKET_INDEX(n_util, NUM_LOW_UTIL_BUCKETS, bucket_index, 0);
-        this->insertPageInBucket(&this->low_utilization_buckets[bucket_index], p, n_util);    
+
+    return total;
+}
+
+void GCAllocator::processPage(PageInfo* p) noexcept
+{
+    uint8_t old_class = p->utilclass;
+    uint8_t n_class = this->getUtilClass(p);
+    p->utilclass = n_class;
+
+    if(n_class == PAGE_UTIL_CLASS_EMPTY) {
+        p->pageset = PAGE_SET_NONE;
+        GlobalPageGCManager::g_gc_page_manager.addNewPage(*this->owner, p);
+        this->owner->total_empty_gc_pages++;
     }
-    else if(IS_HIGH_UTIL(n_util)) {
-        GET_BUCKET_INDEX(n_util, NUM_HIGH_UTIL_BUCKETS, bucket_index, 1);
-        this->insertPageInBucket(&this->high_utilization_buckets[bucket_index], p, n_util);
+    else if(IS_LOW_UTIL_CLASS(n_class)) {
+        this->insertPageInBucket(this->low_utilization_buckets, PAGE_SET_LOW_UTIL, n_class - PAGE_UTIL_CLASS_LOW(0), p);
+    }
+    else if(IS_HIGH_UTIL_CLASS(n_class)) {
+        this->insertPageInBucket(this->high_utilization_buckets, PAGE_SET_HIGH_UTIL, n_class - PAGE_UTIL_CLASS_HIGH(0), p);
     }
     // If our page freshly became full we need to gc
-    else if(IS_FULL(n_util) && !IS_FULL(old_util)) {
+    else if(old_class != PAGE_UTIL_CLASS_FULL) {
         // We dont want to collect evac page
         if(!(p == this->evac_page)) {
+            p->pageset = PAGE_SET_PENDING_GC;
             p->next = this->pendinggc_pages;
             pendinggc_pages = p;
         }
         else {
-            p->next = this->filled_pages;
-            filled_pages = p;
+            this->insertPageInFilled(p);
         }
     }
     // If our page was full before and still full put on filled pages
-    else if(IS_FULL(n_util) && IS_FULL(old_util)) {
-        p->next = this->filled_pages;
-        filled_pages = p;
+    else {
+        this->insertPageInFilled(p);
     }
 }
 
 void GCAllocator::processCollectorPages() noexcept
 {
+    this->flushBumpCursors();
+
     if(this->alloc_page != nullptr) {
+#ifdef BSQ_GC_LAZY_SWEEP
+        this->alloc_page->pageset = PAGE_SET_NEEDS_SWEEP;
+        this->alloc_page->next = this->unswept_pages;
+        this->unswept_pages = this->alloc_page;
+#else
         this->alloc_page->rebuild();
         this->processPage(this->alloc_page);
+#endif
 
         this->alloc_page = nullptr;
-        this->freelist = nullptr;
+        this->bumpptr = nullptr;
+        this->bumpend = nullptr;
     }
     
-    if(this->evac_page != nullptr) {
-        this->processPage(this->evac_page);
+    this->releaseEvacuationPage();
 
-        this->evac_page = nullptr;
-        this->evacfreelist = nullptr;
-    }
+    this->evac_slots_last = this->evac_slots_current;
+    this->evac_slots_current = 0;
 
     PageInfo* cur = this->pendinggc_pages;
     while(cur != nullptr) {
         PageInfo* next = cur->next;
 
+#ifdef BSQ_GC_LAZY_SWEEP
+        cur->pageset = PAGE_SET_NEEDS_SWEEP;
+        cur->next = this->unswept_pages;
+        this->unswept_pages = cur;
+#else
         cur->rebuild();
         this->processPage(cur);
+#endif
 
         cur = next;
     }
@@ -155,6 +571,27 @@ void GCAllocator::processCollectorPages() noexcept
 }
 
 
+void GCAllocator::finishCompaction(PageInfo* sources) noexcept
+{
+    this->flushBumpCursors();
+
+    while(sources != nullptr) {
+        PageInfo* next = sources->next;
+
+        //Everything but the pinned objects was moved (and reset) so they are all rebuild keeps
+        sources->rebuild();
+        sources->pageset = PAGE_SET_NONE;
+        this->processPage(sources);
+
+        sources = next;
+    }
+
+    this->releaseEvacuationPage();
+
+    //Compaction moves are not part of the young evacuation volume best fit predicts
+    this->evac_slots_current = 0;
+}
+
 void GCAllocator::allocatorRefreshPage() noexcept
 {
     if(this->alloc_page == nullptr) {
@@ -162,23 +599,94 @@ void GCAllocator::allocatorRefreshPage() noexcept
     }
     else {
         // Rotate collection pages
+        this->alloc_page->bumpptr = this->bumpptr;
         processPage(this->alloc_page);
         this->alloc_page = nullptr;
 
-        //use BSQ_COLLECTION_THRESHOLD; NOTE: ONLY INCREMENT when we have a full page
+        //use BSQ_COLLECTION_THRESHOLD_BYTES; NOTE: ONLY INCREMENT when we have a full page
         gtl_info.newly_filled_pages_count++;
 
-        // If we exceed our filled pages thresh collect
-        if(gtl_info.newly_filled_pages_count == BSQ_COLLECTION_THRESHOLD) {
+        // If we exceed our allocation thresh collect (an incremental mark starts ahead of that and runs a slice per filled page -- a concurrent one is only started)
+        if(gtl_info.getNewlyAllocatedBytes() >= BSQ_COLLECTION_THRESHOLD_BYTES) {
             if(!gtl_info.disable_automatic_collections) {
                 collect();
             }
         }
+        else if(gtl_info.isMarkAheadEnabled() && gtl_info.getNewlyAllocatedBytes() >= BSQ_INCREMENTAL_MARK_START_BYTES) {
+            if(!gtl_info.disable_automatic_collections) {
+                incrementalMarkStep();
+            }
+        }
     
         this->alloc_page = this->getFreshPageForAllocator();
     }
 
-    this->freelist = this->alloc_page->freelist;
+    this->bumpptr = this->alloc_page->bumpptr;
+    this->bumpend = this->alloc_page->getBumpEnd();
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+    this->bumpidx = this->alloc_page->getBumpIndex();
+    this->allocscan = 0;
+#endif
+}
+
+void* GCLargeObjectAllocator::allocate(TypeInfoBase* type) noexcept
+{
+    ENSURE_TYPE_LAYOUT(type);
+
+    size_t spansize = GlobalPageGCManager::computeLargeObjectSpanSize(type->type_size);
+
+    //Large spans count against the collection threshold by the bytes they map (not whole blocks -- with 2MB blocks that would collect every other large object)
+    gtl_info.newly_large_object_bytes += spansize;
+    if(gtl_info.getNewlyAllocatedBytes() >= BSQ_COLLECTION_THRESHOLD_BYTES) {
+        if(!gtl_info.disable_automatic_collections) {
+            collect();
+        }
+    }
+    else if(gtl_info.isMarkAheadEnabled() && gtl_info.getNewlyAllocatedBytes() >= BSQ_INCREMENTAL_MARK_START_BYTES) {
+        if(!gtl_info.disable_automatic_collections) {
+            incrementalMarkStep();
+        }
+    }
+
+    PageInfo* span = GlobalPageGCManager::g_gc_page_manager.allocateLargeObjectSpan(type->type_size);
+    span->next = this->young_spans;
+    this->young_spans = span;
+
+    this->live_bytes += type->type_size;
+    MEM_STATS_OP(gtl_info.total_large_object_bytes += spansize);
+
+    void* entry = span->data;
+    SET_ALLOC_LAYOUT_HANDLE_CANARY(entry, type);
+    SETUP_ALLOC_INITIALIZE_FRESH_META(SETUP_ALLOC_LAYOUT_GET_META_PTR(entry), type);
+
+    return SETUP_ALLOC_LAYOUT_GET_OBJ_PTR(entry);
+}
+
+void GCLargeObjectAllocator::release(PageInfo* span) noexcept
+{
+    MetaData* meta = span->getMetaEntryAtIndex(0);
+    this->live_bytes -= meta->type->type_size;
+    MEM_STATS_OP(gtl_info.total_large_object_bytes -= span->spansize);
+
+    GlobalPageGCManager::g_gc_page_manager.releaseLargeObjectSpan(span);
+}
+
+void GCLargeObjectAllocator::processCollectorSpans() noexcept
+{
+    PageInfo* cur = this->young_spans;
+    while(cur != nullptr) {
+        PageInfo* next = cur->next;
+        cur->next = nullptr;
+
+        //Survivors were promoted in place so anything still young was not reached
+        if(GC_SHOULD_PROCESS_AS_YOUNG(cur->getMetaEntryAtIndex(0))) {
+            this->release(cur);
+        }
+
+        cur = next;
+    }
+    this->young_spans = nullptr;
 }
 
 #ifdef MEM_STATS
@@ -189,38 +697,57 @@ inline void process(PageInfo* page)
     gtl_info.total_live_bytes += (page->allocsize * (page->entrycount - page->freecount));
 }
 
-void traverseBST(PageInfo* node) 
+void traverseList(PageInfo* node) 
 {
-    if (!node) return;
-
     PageInfo* current = node;
     while (current != nullptr) {
         process(current);
         current = current->next;
     }
-    
-    traverseBST(node->left);
-    traverseBST(node->right); 
 }
 
+#ifdef BSQ_GC_LAZY_SWEEP
+//Free counts on unswept pages are stale so count the survivors directly -- only stats builds pay for this scan in the pause
+void traverseUnsweptList(PageInfo* node)
+{
+    for(PageInfo* current = node; current != nullptr; current = current->next) {
+        uint64_t live = 0;
+#ifdef BSQ_GC_ALLOC_BITMAP
+        const uint64_t* old = current->getOldBits();
+        for(uint32_t w = 0; w < current->bitmapwords; w++) {
+            live += (uint64_t)__builtin_popcountl(old[w]);
+        }
+#else
+        size_t bumpidx = current->getBumpIndex();
+        for(size_t i = 0; i < bumpidx; i++) {
+            if(!GC_SHOULD_FREE_LIST_ADD(current->getMetaEntryAtIndex(i))) {
+                live++;
+            }
+        }
+#endif
+        gtl_info.total_live_bytes += current->allocsize * live;
+    }
+}
+#endif
+
 void GCAllocator::updateMemStats() 
 {
     //compute stats for filled pages
-    PageInfo* filled_it = this->filled_pages;
-    while(filled_it != nullptr) {
-        process(filled_it);
-        filled_it = filled_it->next;
-    }
+    traverseList(this->filled_pages);
 
     // Compute stats for high util pages
     for(int i = 0; i < NUM_HIGH_UTIL_BUCKETS; i++) {
-        traverseBST(this->high_utilization_buckets[i]);
+        traverseList(this->high_utilization_buckets[i]);
     }
 
     // Compute stats for low util pages
     for(int i = 0; i < NUM_LOW_UTIL_BUCKETS; i++) {
-        traverseBST(this->low_utilization_buckets[i]);
+        traverseList(this->low_utilization_buckets[i]);
     }
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    traverseUnsweptList(this->unswept_pages);
+#endif
 }
 
 #endif
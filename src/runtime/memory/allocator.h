@@ -3,8 +3,11 @@
 #include "../common.h"
 #include "../support/arraylist.h"
 #include "../support/pagetable.h"
+#include "../support/lockfreestack.h"
 #include "gc.h"
 
+#include <atomic>
+
 //Can also use other values like 0xFFFFFFFFFFFFFFFFul
 #define ALLOC_DEBUG_MEM_INITIALIZE_VALUE 0x0ul
 
@@ -21,6 +24,40 @@
 #define MEM_STATS_ARG(X)
 #endif
 
+//
+//Build with -DBSQ_GC_ALLOC_BITMAP to track slots with per-page bitmaps (stored right after the PageInfo header) instead of freelists
+//  -- young bits are set when a young object is allocated and all cleared when the page is rebuilt (every young object was evacuated, promoted, or is dead)
+//  -- old bits are set for evacuated or promoted-in-place objects and cleared when a decrement frees the object
+//  -- a slot is in use iff its young or old bit is set, so rebuild is a clear + popcount over the words and allocation is a find-first-zero
+//
+#ifdef BSQ_GC_ALLOC_BITMAP
+#define ALLOC_BITMAP_OP(X) X
+#else
+#define ALLOC_BITMAP_OP(X)
+#endif
+
+#ifdef BSQ_GC_MARK_BITMAP
+#define MARK_BITMAP_OP(X) X
+#else
+#define MARK_BITMAP_OP(X)
+#endif
+
+//Bitmaps stored between the PageInfo header and the first slot (young + old and/or mark + root)
+#if defined(BSQ_GC_ALLOC_BITMAP) && defined(BSQ_GC_MARK_BITMAP)
+#define PAGE_SIDE_BITMAP_COUNT 4
+#elif defined(BSQ_GC_ALLOC_BITMAP) || defined(BSQ_GC_MARK_BITMAP)
+#define PAGE_SIDE_BITMAP_COUNT 2
+#else
+#define PAGE_SIDE_BITMAP_COUNT 0
+#endif
+
+//
+//Build with -DBSQ_GC_LAZY_SWEEP to defer rebuilding the alloc and pending gc pages out of the collection pause
+//  -- at the end of a collection these pages are just moved to the allocator's unswept list (with stale free lists and counts)
+//  -- they are swept when getFreshPageForAllocator/getFreshPageForEvacuation run out of bucketed pages, so the cost is spread over allocation
+//  -- dead young objects keep their metadata until the sweep so conservative root checks must skip young slots on unswept pages
+//
+
 // Allows us to correctly determine pointer offsets
 #ifdef ALLOC_DEBUG_CANARY
 #define REAL_ENTRY_SIZE(ESIZE) (ALLOC_DEBUG_CANARY_SIZE + ESIZE + sizeof(MetaData) + ALLOC_DEBUG_CANARY_SIZE)
@@ -28,6 +65,74 @@
 #define REAL_ENTRY_SIZE(ESIZE) (ESIZE + sizeof(MetaData))
 #endif
 
+////////////////////////////////
+//Size classes
+
+//Objects up to this size are allocated from size class pages
+#define BSQ_SIZE_CLASS_MAX_BYTES 1024ul
+
+//Exact 8 byte classes up to 256 bytes then 8 classes per doubling (so at most 12.5% internal waste)
+#define BSQ_SIZE_CLASS_EXACT_MAX_BYTES 256ul
+#define BSQ_SIZE_CLASSES_PER_DOUBLING 8ul
+#define BSQ_SIZE_CLASS_COUNT ((BSQ_SIZE_CLASS_EXACT_MAX_BYTES / BSQ_MEM_ALIGNMENT) + (2 * BSQ_SIZE_CLASSES_PER_DOUBLING))
+
+static_assert(BSQ_SIZE_CLASS_COUNT <= BSQ_MAX_ALLOC_SLOTS, "Too many size classes for the allocator slots");
+
+struct GCSizeClassTable
+{
+    uint16_t classbytes[BSQ_SIZE_CLASS_COUNT]; //allocsize of each class
+    uint8_t classindex[(BSQ_SIZE_CLASS_MAX_BYTES / BSQ_MEM_ALIGNMENT) + 1]; //indexed by (size + 7) >> 3
+
+    constexpr GCSizeClassTable() noexcept : classbytes{}, classindex{}
+    {
+        size_t cidx = 0;
+        size_t bytes = BSQ_MEM_ALIGNMENT;
+        while(bytes <= BSQ_SIZE_CLASS_MAX_BYTES) {
+            this->classbytes[cidx++] = (uint16_t)bytes;
+
+            if(bytes < BSQ_SIZE_CLASS_EXACT_MAX_BYTES) {
+                bytes += BSQ_MEM_ALIGNMENT;
+            }
+            else {
+                //step is fixed for each doubling -- e.g. 32 bytes for all classes in (256, 512]
+                size_t base = BSQ_SIZE_CLASS_EXACT_MAX_BYTES;
+                while(base * 2 <= bytes) {
+                    base *= 2;
+                }
+                bytes += base / BSQ_SIZE_CLASSES_PER_DOUBLING;
+            }
+        }
+
+        size_t ccls = 0;
+        for(size_t i = 0; i <= (BSQ_SIZE_CLASS_MAX_BYTES / BSQ_MEM_ALIGNMENT); i++) {
+            while(this->classbytes[ccls] < i * BSQ_MEM_ALIGNMENT) {
+                ccls++;
+            }
+            this->classindex[i] = (uint8_t)ccls;
+        }
+    }
+};
+
+inline constexpr GCSizeClassTable g_size_class_table;
+
+static_assert(g_size_class_table.classbytes[BSQ_SIZE_CLASS_COUNT - 1] == BSQ_SIZE_CLASS_MAX_BYTES, "Size class table does not end at the max class size");
+
+//Size class index for an object of the given size (excluding metadata) -- size must be <= BSQ_SIZE_CLASS_MAX_BYTES
+constexpr size_t getSizeClassIndex(size_t size) noexcept
+{
+    return g_size_class_table.classindex[(size + (BSQ_MEM_ALIGNMENT - 1)) / BSQ_MEM_ALIGNMENT];
+}
+
+constexpr size_t getSizeClassBytes(size_t cidx) noexcept
+{
+    return g_size_class_table.classbytes[cidx];
+}
+
+constexpr bool isSizeClassBytes(size_t size) noexcept
+{
+    return size != 0 && size <= BSQ_SIZE_CLASS_MAX_BYTES && getSizeClassBytes(getSizeClassIndex(size)) == size;
+}
+
 ////////////////////////////////
 //Memory allocator
 
@@ -36,6 +141,15 @@
 //  -- After initialization a GC must be run to promote all values to old ref-count space
 //  -- TODO: when we add multi-threading we need to use the special root-ref tag for these roots as well -- then we can skip re-scanning these after the promotion collection
 
+//The page set a PageInfo is currently in -- alloc/evac pages and pages in the empty pool are not in any set
+#define PAGE_SET_NONE 0
+#define PAGE_SET_PENDING_GC 1
+#define PAGE_SET_LOW_UTIL 2
+#define PAGE_SET_HIGH_UTIL 3
+#define PAGE_SET_FILLED 4
+#define PAGE_SET_NEEDS_SWEEP 5
+#define PAGE_SET_COMPACTING 6
+
 class GlobalDataStorage
 {
 public:
@@ -63,25 +177,137 @@ class PageInfo
 {
 public:
     FreeListEntry* freelist; //allocate from here until nullptr
+    uint8_t* bumpptr; //first slot that has never been handed out -- slots at or after this have no valid metadata
     PageInfo* next;
-    PageInfo* left; //left pointer in bst
-    PageInfo* right; //right pointer in bst
+    PageInfo* prev; //back link when the page is in a utilization bucket or the filled list (so removal is O(1))
 
     uint8_t* data; //start of the data block
 
     uint16_t allocsize; //size of the alloc entries in this page (excluding metadata)
     uint16_t realsize; //size of the alloc entries in this page (including metadata and other stuff)
     
-    uint16_t entrycount; //max number of objects that can be allocated from this Page
-    uint16_t freecount;
+    //32 bits since large blocks (e.g. 2MB) can hold more than 2^16 small entries
+    uint32_t entrycount; //max number of objects that can be allocated from this Page
+    uint32_t freecount;
+
+    uint32_t pending_decs_count;
+
+    uint8_t pageset; //which of its allocator's page sets the page is in (PAGE_SET_X)
+    uint8_t utilclass; //utilization class when the page was last placed in a page set (PAGE_UTIL_CLASS_X)
+    uint8_t indecremented; //set while the page is on the thread's decremented_pages list so it is recorded (and reprocessed) only once
+
+    size_t spansize; //total bytes mapped for a large object span (0 for size class pages)
+    uint64_t empty_timestamp; //when the page was put in the empty page pool (ms, monotonic clock)
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+    uint32_t bitmapwords; //number of 64 bit words in each of the young and old bitmaps
+
+    inline uint64_t* getYoungBits() const noexcept {
+        return (uint64_t*)((uint8_t*)this + sizeof(PageInfo));
+    }
+
+    inline uint64_t* getOldBits() const noexcept {
+        return this->getYoungBits() + this->bitmapwords;
+    }
+
+    inline bool isSlotInUse(size_t idx) const noexcept {
+        return ((this->getYoungBits()[idx / 64] | this->getOldBits()[idx / 64]) & (1ul << (idx % 64))) != 0;
+    }
+
+    inline void setYoungBit(size_t idx) noexcept {
+        this->getYoungBits()[idx / 64] |= (1ul << (idx % 64));
+    }
 
-    float approx_utilization;
-    uint16_t pending_decs_count;
+    inline void setOldBit(size_t idx) noexcept {
+        this->getOldBits()[idx / 64] |= (1ul << (idx % 64));
+    }
+
+    inline void clearOldBit(size_t idx) noexcept {
+        this->getOldBits()[idx / 64] &= ~(1ul << (idx % 64));
+    }
+
+    //First slot that is not in use starting from word scanword (updated to the word the slot was found in) -- entrycount if there is none
+    inline size_t findFreeSlot(uint32_t& scanword) const noexcept {
+        const uint64_t* young = this->getYoungBits();
+        const uint64_t* old = this->getOldBits();
+
+        for(uint32_t w = scanword; w < this->bitmapwords; w++) {
+            uint64_t freebits = ~(young[w] | old[w]);
+            if(freebits != 0) {
+                size_t idx = ((size_t)w * 64) + (size_t)__builtin_ctzl(freebits);
+                if(idx >= this->entrycount) {
+                    break;
+                }
+
+                scanword = w;
+                return idx;
+            }
+        }
+
+        scanword = this->bitmapwords;
+        return this->entrycount;
+    }
+#endif
+
+#ifdef BSQ_GC_MARK_BITMAP
+    uint32_t markwords; //number of 64 bit words in each of the mark and root bitmaps (0 for large object spans)
+
+    //After the alloc bitmaps (if they are on)
+    inline uint64_t* getMarkBits() const noexcept {
+#ifndef BSQ_GC_ALLOC_BITMAP
+        return (uint64_t*)((uint8_t*)this + sizeof(PageInfo));
+#else
+        return this->getOldBits() + this->bitmapwords;
+#endif
+    }
+
+    inline uint64_t* getRootBits() const noexcept {
+        return this->getMarkBits() + this->markwords;
+    }
+
+    inline void clearMarkBits() noexcept {
+        xmem_zerofill(this->getMarkBits(), this->markwords);
+    }
+#endif
+
+#if defined(BSQ_GC_ALLOC_BITMAP) || defined(BSQ_GC_MARK_BITMAP)
+    //Size the bitmaps for the most entries that could fit without them (the real count can only be smaller)
+    static constexpr uint32_t computeBitmapWords(uint16_t realsize) noexcept {
+        return (uint32_t)((((BSQ_BLOCK_ALLOCATION_SIZE - sizeof(PageInfo)) / realsize) + 63) / 64);
+    }
+#endif
+
+    //Offset of the first slot from the start of the block
+    static constexpr size_t computeDataOffset(uint16_t realsize) noexcept {
+#if PAGE_SIDE_BITMAP_COUNT == 0
+        return sizeof(PageInfo);
+#else
+        return sizeof(PageInfo) + (PAGE_SIDE_BITMAP_COUNT * computeBitmapWords(realsize) * sizeof(uint64_t));
+#endif
+    }
+
+    //Every page of a size class has the same number of entries
+    static constexpr uint32_t computeEntryCount(uint16_t realsize) noexcept {
+        return (uint32_t)((BSQ_BLOCK_ALLOCATION_SIZE - computeDataOffset(realsize)) / realsize);
+    }
 
     static PageInfo* initialize(void* block, uint16_t allocsize, uint16_t realsize) noexcept;
+    static PageInfo* initializeLargeObjectSpan(void* block, size_t spansize, size_t objsize) noexcept;
+
+    inline bool isLargeObjectPage() const noexcept {
+        return this->spansize != 0;
+    }
 
     void rebuild() noexcept;
 
+    inline uint8_t* getBumpEnd() const noexcept {
+        return this->data + (size_t)this->entrycount * (size_t)this->realsize;
+    }
+
+    inline size_t getBumpIndex() const noexcept {
+        return (size_t)(this->bumpptr - this->data) / (size_t)this->realsize;
+    }
+
     static inline PageInfo* extractPageFromPointer(void* p) noexcept {
         return (PageInfo*)((uintptr_t)(p) & PAGE_ADDR_MASK);
     }
@@ -125,32 +351,217 @@ public:
     }
 };
 
+#ifdef BSQ_GC_MARK_BITMAP
+//Side bitmap bits of a size class object -- large objects use their header bits
+#define GC_SIDE_BIT_WORD(BITS, IDX) ((BITS) + ((IDX) / 64))
+#define GC_SIDE_BIT(IDX) (1ul << ((IDX) % 64))
+
+inline bool gcSideBitsIsMarked(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        return GC_GET_META_DATA_ADDR(obj)->ismarked;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    return (*GC_SIDE_BIT_WORD(page->getMarkBits(), idx) & GC_SIDE_BIT(idx)) != 0;
+}
+
+inline bool gcSideBitsIsRoot(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        return GC_GET_META_DATA_ADDR(obj)->isroot;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    return (*GC_SIDE_BIT_WORD(page->getRootBits(), idx) & GC_SIDE_BIT(idx)) != 0;
+}
+
+inline void gcSideBitsSetMarked(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        GC_GET_META_DATA_ADDR(obj)->ismarked = true;
+        return;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    *GC_SIDE_BIT_WORD(page->getMarkBits(), idx) |= GC_SIDE_BIT(idx);
+}
+
+inline void gcSideBitsSetRoot(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        GC_GET_META_DATA_ADDR(obj)->isroot = true;
+        return;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    *GC_SIDE_BIT_WORD(page->getRootBits(), idx) |= GC_SIDE_BIT(idx);
+}
+
+//Parallel marking -- true if this thread set the mark (neighbors share the word so the set has to be an atomic or)
+inline bool gcSideBitsTryMarkAtomic(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        MetaData* meta = GC_GET_META_DATA_ADDR(obj);
+        return !__atomic_load_n(&meta->ismarked, __ATOMIC_RELAXED) && !__atomic_exchange_n(&meta->ismarked, true, __ATOMIC_RELAXED);
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    uint64_t* word = GC_SIDE_BIT_WORD(page->getMarkBits(), idx);
+    return ((__atomic_load_n(word, __ATOMIC_RELAXED) & GC_SIDE_BIT(idx)) == 0) && ((__atomic_fetch_or(word, GC_SIDE_BIT(idx), __ATOMIC_RELAXED) & GC_SIDE_BIT(idx)) == 0);
+}
+
+inline void gcSideBitsClearMarked(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        GC_GET_META_DATA_ADDR(obj)->ismarked = false;
+        return;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    *GC_SIDE_BIT_WORD(page->getMarkBits(), idx) &= ~GC_SIDE_BIT(idx);
+}
+
+inline void gcSideBitsClearRootMark(void* obj) noexcept
+{
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) [[unlikely]] {
+        MetaData* meta = GC_GET_META_DATA_ADDR(obj);
+        meta->ismarked = false;
+        meta->isroot = false;
+        return;
+    }
+
+    size_t idx = PageInfo::getIndexForObjectInPage(obj);
+    *GC_SIDE_BIT_WORD(page->getMarkBits(), idx) &= ~GC_SIDE_BIT(idx);
+    *GC_SIDE_BIT_WORD(page->getRootBits(), idx) &= ~GC_SIDE_BIT(idx);
+}
+#endif
+
+inline uint64_t getDecommitClockMS() noexcept
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000ul) + ((uint64_t)ts.tv_nsec / 1000000ul);
+}
+
+static_assert(BSQ_GC_RESERVATION_SIZE % BSQ_GC_COMMIT_SLAB_SIZE == 0, "Reservations must be a whole number of commit slabs");
+
+//Controls when empty pages are handed back to the OS -- set min_pool_pages to SIZE_MAX to never decommit
+struct GCDecommitPolicy
+{
+    size_t min_pool_pages; //most recently emptied pages that always stay committed so a new spike does not fault them back in
+    uint64_t min_age_ms; //pages must have been empty at least this long before they are decommitted
+    bool lazy_free; //use MADV_FREE (kernel reclaims only under memory pressure) instead of MADV_DONTNEED
+    uint64_t background_interval_ms; //if non-zero decommit on a background thread with this period instead of after each collection
+};
+
+struct BSQMemoryTheadLocalInfo;
+
+//Thread local stack of empty pages in front of the global pool -- pages here are hot and never decommitted
+class GCPageCache
+{
+public:
+    size_t count;
+    PageInfo* pages[BSQ_PAGE_CACHE_CAPACITY];
+
+    GCPageCache() noexcept : count(0), pages{} { }
+};
+
 class GlobalPageGCManager
 {
 private:
-    PageInfo* empty_pages;
+    //Empty pages are handed between threads (and the decommitter) without taking the GC lock
+    TaggedLockFreeStack<PageInfo> empty_pages;
     PageTableInUseInfo pagetable;
 
+    //Blocks whose memory was given back to the OS -- they stay in the pagetable and are reused (refaulted) before fresh blocks
+    ArrayList<void*> decommitted_pages;
+    bool decommitted_pages_init;
+    size_t decommitted_count;
+
+    GCDecommitPolicy decommit_policy;
+    std::atomic<bool> decommit_thread_running;
+    thrd_t decommit_thread;
+
+    static int decommitThreadMain(void* arg) noexcept;
+
+    //Move a batch of pages between a thread page cache and the global pool -- only the decommitted/fresh block fallback takes the lock
+    void refillPageCache(BSQMemoryTheadLocalInfo& owner) noexcept;
+    void drainPageCache(GCPageCache& cache, size_t keep) noexcept;
+
+    //Fresh blocks are bumped out of [commit_cursor, commit_end) and the committed range grows a slab at a time up to reserve_end
+    uint8_t* commit_cursor;
+    uint8_t* commit_end;
+    uint8_t* reserve_end;
+
+    void commitSlab() noexcept;
+
+    inline void* getFreshBlock() noexcept
+    {
+        if(this->commit_cursor == this->commit_end) [[unlikely]] {
+            this->commitSlab();
+        }
+
+        void* block = this->commit_cursor;
+        this->commit_cursor += BSQ_BLOCK_ALLOCATION_SIZE;
+        return block;
+    }
+
 public:
     static GlobalPageGCManager g_gc_page_manager;
 
-    GlobalPageGCManager() noexcept : empty_pages(nullptr) { }
+    GlobalPageGCManager() noexcept : empty_pages(), pagetable(), decommitted_pages(), decommitted_pages_init(false), decommitted_count(0), decommit_policy({ BSQ_DECOMMIT_MIN_POOL_PAGES, BSQ_DECOMMIT_MIN_AGE_MS, false, 0 }), decommit_thread_running(false), decommit_thread(), commit_cursor(nullptr), commit_end(nullptr), reserve_end(nullptr) { }
+
+    //Pages come from (and go back to) the page cache of the thread that owns the allocator -- GC worker threads work with their collector's cache
+    PageInfo* allocateFreshPage(BSQMemoryTheadLocalInfo& owner, uint16_t entrysize, uint16_t realsize) noexcept;
+    void addNewPage(BSQMemoryTheadLocalInfo& owner, PageInfo* newPage) noexcept;
+
+    //Return all of the pages in the thread's page cache to the global pool (at thread teardown see ReleaseBSQMemoryTheadLocalInfo)
+    void flushPageCache(BSQMemoryTheadLocalInfo& owner) noexcept;
+
+    //Starts or stops the background decommit thread to match the policy
+    void setDecommitPolicy(const GCDecommitPolicy& policy) noexcept;
+
+    bool isBackgroundDecommitEnabled() const noexcept
+    {
+        return this->decommit_thread_running.load(std::memory_order_acquire);
+    }
+
+    //Give cold empty pages back to the OS, returns the number of pages decommitted
+    size_t decommitColdPages() noexcept;
+
+    size_t getDecommittedPageCount() const noexcept
+    {
+        return this->decommitted_count;
+    }
+
+    //Large objects get their own span of blocks that is mapped and unmapped as a unit
+    //  -- only the start of the span needs to be block aligned so the size is rounded to OS pages
+    static constexpr size_t computeLargeObjectSpanSize(size_t objsize) noexcept
+    {
+        return (sizeof(PageInfo) + REAL_ENTRY_SIZE(objsize) + (BSQ_OS_PAGE_SIZE - 1)) & ~(BSQ_OS_PAGE_SIZE - 1);
+    }
 
-    PageInfo* allocateFreshPage(uint16_t entrysize, uint16_t realsize) noexcept;
+    PageInfo* allocateLargeObjectSpan(size_t objsize) noexcept;
+    void releaseLargeObjectSpan(PageInfo* span) noexcept;
 
     bool pagetable_query(void* addr) const noexcept
     {
         return this->pagetable.pagetable_query(addr);
     }
 
-    void addNewPage(PageInfo* newPage) noexcept
+    //The page that owns this address -- for addresses in later blocks of a large object span this is the span head
+    PageInfo* pagetable_lookup(void* addr) const noexcept
     {
-        GC_MEM_LOCK_ACQUIRE();
-
-        newPage->next = empty_pages;  
-        empty_pages = newPage;    
-        
-        GC_MEM_LOCK_RELEASE();
+        return (PageInfo*)this->pagetable.pagetable_lookup(addr);
     }
 };
 
@@ -166,46 +577,134 @@ public:
 #define SET_ALLOC_LAYOUT_HANDLE_CANARY(BASEALLOC, T) PageInfo::initializeWithDebugInfo(BASEALLOC, T)
 #endif
 
-#define SETUP_ALLOC_INITIALIZE_FRESH_META(META, T) *(META) = { .type=(T), .isalloc=true, .isyoung=true, .ismarked=false, .isroot=false, .forward_index=MAX_FWD_INDEX, .ref_count=0 }
-#define SETUP_ALLOC_INITIALIZE_CONVERT_OLD_META(META, T) *(META) = { .type=(T), .isalloc=true, .isyoung=false, .ismarked=false, .isroot=false, .forward_index=MAX_FWD_INDEX, .ref_count=0 }
+#define SETUP_ALLOC_INITIALIZE_FRESH_META(META, T) *(META) = { .type=(T), .isalloc=true, .isyoung=true, .ismarked=false, .isroot=false, .isforwarded=false, .ref_count=0 }
+#define SETUP_ALLOC_INITIALIZE_CONVERT_OLD_META(META, T) *(META) = { .type=(T), .isalloc=true, .isyoung=false, .ismarked=false, .isroot=false, .isforwarded=false, .ref_count=0 }
+
+//Pointer layouts of types described by a ptr_mask are compiled when the type is registered -- register types at startup (after INIT_LOCKS)
+//A type that was not registered is compiled on its first allocation (one load and a predicted branch per allocate) so it is never scanned without a layout
+//Types derived with BSQTypeLayout are compiled at compile time and registering them does nothing
+void compileTypeLayout(TypeInfoBase* type) noexcept;
+#define REGISTER_TYPE(T) compileTypeLayout(T)
+#define ENSURE_TYPE_LAYOUT(T) if(__atomic_load_n(&(T)->layout_kind, __ATOMIC_ACQUIRE) == PTR_LAYOUT_UNCOMPILED) [[unlikely]] { compileTypeLayout(T); }
 
 #define AllocType(T, A, L) (T*)(A.allocate(L))
 
-#define CALC_APPROX_UTILIZATION(P) 1.0f - ((float)P->freecount / (float)P->entrycount)
+//Allocate from the thread local size class allocators (created on first use)
+#define AllocTypeAuto(T, L) (T*)(gtl_info.allocate(L))
 
 #define NUM_LOW_UTIL_BUCKETS 12
 #define NUM_HIGH_UTIL_BUCKETS 6
 
-#define IS_LOW_UTIL(U) (U >= 0.01f && U <= 0.60f)
-#define IS_HIGH_UTIL(U) (U > 0.60f && U <= 0.90f)
-
-//<=1.0f is very crucial here because new pages start at 100.0f, wihout we just reprocess them until OOM
-#define IS_FULL(U) (U > 0.90f && U <= 1.0f)
-
-#define UTILIZATIONS_ARE_EQUAL(F1, F2) (-0.00001 <= (F1 - F2) && (F1 - F2) <= 0.00001)
-
-//Find proper bucket based on increments of 0.05f
-#define GET_BUCKET_INDEX(U, N, I, O)                \
-do {                                                \
-    float tmp_util = 0.0f;                          \
-    if(O) {                                         \
-        tmp_util = 0.60f;                           \
-    }                                               \
-    for (int i = 0; i < N; i++) {                   \
-        float new_tmp_util = tmp_util + 0.05f;      \
-        if (U > tmp_util && U <= new_tmp_util) {    \
-            I = i;                                  \
-            break;                                  \
-        }                                           \
-        tmp_util = new_tmp_util;                    \
-    }                                               \
-} while (0)
+//
+//Pages are classified by their live count in 5% steps of the entry count (rounded up) -- 
+//empty, one low util bucket per step up to 60%, one high util bucket per step up to 90%, and full above that
+//
+#define PAGE_UTIL_STEPS 20
+#define PAGE_UTIL_CLASS_EMPTY 0
+#define PAGE_UTIL_CLASS_LOW(B) (1 + (B))
+#define PAGE_UTIL_CLASS_HIGH(B) (1 + NUM_LOW_UTIL_BUCKETS + (B))
+#define PAGE_UTIL_CLASS_FULL (1 + NUM_LOW_UTIL_BUCKETS + NUM_HIGH_UTIL_BUCKETS)
+#define PAGE_UTIL_CLASS_UNSET 0xFF //fresh page that has not been placed in a page set yet
+
+#define IS_LOW_UTIL_CLASS(C) ((C) >= PAGE_UTIL_CLASS_LOW(0) && (C) < PAGE_UTIL_CLASS_HIGH(0))
+#define IS_HIGH_UTIL_CLASS(C) ((C) >= PAGE_UTIL_CLASS_HIGH(0) && (C) < PAGE_UTIL_CLASS_FULL)
+
+static_assert(NUM_LOW_UTIL_BUCKETS + NUM_HIGH_UTIL_BUCKETS < PAGE_UTIL_STEPS, "Utilization buckets must leave room for the full class");
+static_assert(BSQ_COMPACTION_SPARSE_BUCKETS <= NUM_LOW_UTIL_BUCKETS, "Compaction only takes pages from the low utilization buckets");
+
+//Max entries in the per size class utilization table -- with large blocks consecutive live counts share an entry
+#define PAGE_UTIL_TABLE_SIZE 256
+
+//
+//Policies for picking a page from the utilization buckets when the alloc or evac page is refreshed (set with GCAllocator::setPageSelectionPolicy)
+//  -- LOWEST_UTIL: emptiest page first (the default) so allocation gets the most room per page
+//  -- FULLEST_FIRST: fullest page first so sparse pages are left alone and can drain to empty
+//  -- BEST_FIT: for evacuation the fullest page that still fits what is left of the last collection's evacuation volume (allocation uses LOWEST_UTIL)
+//  -- ADDRESS_ORDERED: lowest address page first to keep the live heap packed at the bottom of the address space (scans the candidate buckets)
+//
+#define PAGE_SELECT_LOWEST_UTIL 0
+#define PAGE_SELECT_FULLEST_FIRST 1
+#define PAGE_SELECT_BEST_FIT 2
+#define PAGE_SELECT_ADDRESS_ORDERED 3
+#define PAGE_SELECT_POLICY_COUNT 4
+
+//
+//Private evacuation page of one GC worker for one size class (like a PLAB) so parallel evacuation only bump allocates without synchronization
+//  -- pages come from and go back to the size class allocator with GCAllocator::refillEvacBuffer/releaseEvacBuffer and the callers serialize those
+//
+class EvacBuffer
+{
+public:
+    PageInfo* page;
+    uint8_t* bumpptr;
+    uint8_t* bumpend;
+#ifdef BSQ_GC_ALLOC_BITMAP
+    size_t bumpidx;
+    uint32_t scan;
+#endif
+    uint16_t realsize;
+    size_t startfree; //free count of the page when the buffer got it (for the best fit evacuation volume)
+
+    EvacBuffer() noexcept : page(nullptr), bumpptr(nullptr), bumpend(nullptr), realsize(0), startfree(0) { }
+
+    //nullptr when the page is full (refill and retry)
+    inline void* allocate(TypeInfoBase* type) noexcept
+    {
+        void* entry;
+        if(this->bumpptr != this->bumpend) [[likely]] {
+            entry = this->bumpptr;
+            this->bumpptr += this->realsize;
+            ALLOC_BITMAP_OP(this->page->setOldBit(this->bumpidx++));
+        }
+        else {
+            if(this->page == nullptr) {
+                return nullptr;
+            }
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+            size_t idx = this->page->findFreeSlot(this->scan);
+            if(idx == this->page->entrycount) {
+                return nullptr;
+            }
+
+            this->page->setOldBit(idx);
+            entry = this->page->getFreelistEntryAtIndex(idx);
+#else
+            FreeListEntry* fentry = this->page->freelist;
+            if(fentry == nullptr) {
+                return nullptr;
+            }
+
+            this->page->freelist = fentry->next;
+            entry = fentry;
+#endif
+        }
+
+        this->page->freecount--;
+
+        SET_ALLOC_LAYOUT_HANDLE_CANARY(entry, type);
+        SETUP_ALLOC_INITIALIZE_CONVERT_OLD_META(SETUP_ALLOC_LAYOUT_GET_META_PTR(entry), type);
+
+        return SETUP_ALLOC_LAYOUT_GET_OBJ_PTR(entry);
+    }
+};
 
 class GCAllocator
 {
 private:
-    FreeListEntry* freelist;
-    FreeListEntry* evacfreelist;
+    //Bump cursors for the alloc/evac pages -- these are the live values and are written back to the page with flushBumpCursors
+    uint8_t* bumpptr;
+    uint8_t* bumpend;
+    uint8_t* evacbumpptr;
+    uint8_t* evacbumpend;
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+    //Slot index of the bump cursors (so the fast path does not divide) and the bitmap word we last found a free slot in
+    size_t bumpidx;
+    size_t evacbumpidx;
+    uint32_t allocscan;
+    uint32_t evacscan;
+#endif
 
     PageInfo* alloc_page; // Page in which we are currently allocating from
     PageInfo* evac_page; // Page in which we are currently evacuating from
@@ -216,8 +715,12 @@ private:
 
     PageInfo* pendinggc_pages; // Pages that are pending GC
 
-    // Each "bucket" is a binary tree storing 5% of variance in approx_utiliation
-    PageInfo* low_utilization_buckets[NUM_LOW_UTIL_BUCKETS]; // Pages with 1-60% utilization (does not hold fully empty)
+#ifdef BSQ_GC_LAZY_SWEEP
+    PageInfo* unswept_pages; // Pages left by the last collection(s) that still need to be rebuilt (singly linked)
+#endif
+
+    // Each "bucket" is a doubly linked list of the pages in one 5% utilization class
+    PageInfo* low_utilization_buckets[NUM_LOW_UTIL_BUCKETS]; // Pages with up to 60% utilization (does not hold fully empty)
     PageInfo* high_utilization_buckets[NUM_HIGH_UTIL_BUCKETS]; // Pages with 61-90% utilization 
 
     PageInfo* filled_pages; // Pages with over 90% utilization (no need for buckets here)
@@ -225,182 +728,212 @@ private:
 
     void (*collectfp)();
 
-    void insertPageInBucket(PageInfo** bucket, PageInfo* new_page, float n_util) 
-    {                             
-        if(new_page == nullptr) { //sanity check
-            assert(false);
-        }
-        
-        PageInfo* root = *bucket;     
-        new_page->left = nullptr;
-        new_page->right = nullptr;
-        new_page->next = nullptr;
+    BSQMemoryTheadLocalInfo* owner; //thread whose page cache and page counts this allocator uses (set when it is registered)
+
+    uint8_t alloc_policy; //PAGE_SELECT_X used by getFreshPageForAllocator
+    uint8_t evac_policy; //PAGE_SELECT_X used by getFreshPageForEvacuation
+
+    //Evacuation volume (in slots) for best fit -- what this collection has used so far and what the last collection used in total
+    size_t evac_page_startfree;
+    size_t evac_slots_current;
+    size_t evac_slots_last;
+
+    //The utilization class of a page with live count L is utilclass_table[ceil(L / 2^utilclass_shift)]
+    uint32_t utilclass_shift;
+    uint8_t utilclass_table[PAGE_UTIL_TABLE_SIZE + 1];
+
+    void initializeUtilClassTable() noexcept
+    {
+        size_t entrycount = PageInfo::computeEntryCount(this->realsize);
 
-        //no root case
-        if(root == nullptr) {
-            *bucket = new_page;
-            return ;
+        this->utilclass_shift = 0;
+        while(((entrycount + (1ul << this->utilclass_shift) - 1) >> this->utilclass_shift) > PAGE_UTIL_TABLE_SIZE) {
+            this->utilclass_shift++;
         }
-    
-        PageInfo* current = root;
-        while (current != nullptr) {
-            // If current and our pages utilization are equal we add it to this pages list
-            // TODO: Insert at beginning of list, means we need a reference from parent node
-            if(UTILIZATIONS_ARE_EQUAL(n_util, root->approx_utilization)) {
-                if(current->next == nullptr) {
-                    current->next = new_page;
-                }
-                else {
-                    PageInfo* it = current;
-                    while(it->next != nullptr) {
-                        it = it->next;
-                    }
-                    it->next = new_page;
-                }
-                break;
-            }
 
-            // Traverse down left subtree
-            else if (n_util < current->approx_utilization) {
-                if (current->left == nullptr) {
-                    // Insert as the left child
-                    current->left = new_page;
-                    break;
-                } else {
-                    current = current->left;
-                }
-            } 
+        this->utilclass_table[0] = PAGE_UTIL_CLASS_EMPTY;
+        for(size_t i = 1; i <= PAGE_UTIL_TABLE_SIZE; i++) {
+            //classify each group by its largest live count
+            size_t live = (i << this->utilclass_shift) < entrycount ? (i << this->utilclass_shift) : entrycount;
+            size_t step = ((live * PAGE_UTIL_STEPS) + entrycount - 1) / entrycount;
 
-            // Traverse down right subtree
+            if(step <= NUM_LOW_UTIL_BUCKETS) {
+                this->utilclass_table[i] = PAGE_UTIL_CLASS_LOW(step - 1);
+            }
+            else if(step <= NUM_LOW_UTIL_BUCKETS + NUM_HIGH_UTIL_BUCKETS) {
+                this->utilclass_table[i] = PAGE_UTIL_CLASS_HIGH(step - NUM_LOW_UTIL_BUCKETS - 1);
+            }
             else {
-                if (current->right == nullptr) {
-                    // Insert as the right child
-                    current->right = new_page;
-                    break;
-                } else {
-                    current = current->right;
-                }
+                this->utilclass_table[i] = PAGE_UTIL_CLASS_FULL;
             }
         }
     }
 
-    void deletePageFromBucket(PageInfo** root_ptr, PageInfo* old_page)
+    static inline void pageListPush(PageInfo** list, PageInfo* p) noexcept
     {
-        float old_util = old_page->approx_utilization;
-        PageInfo* root = *root_ptr;
-        if (root == nullptr) {
-            return; 
+        p->prev = nullptr;
+        p->next = *list;
+        if(*list != nullptr) {
+            (*list)->prev = p;
         }
-    
-        if (UTILIZATIONS_ARE_EQUAL(old_util, root->approx_utilization)) {
-            // Handle case where root itself is the node to delete
-            if(root == old_page) {
-                if(root->next != nullptr) {
-                    *root_ptr = root->next;
-                    root->next->left = root->left;  // Preserve left subtree
-                    root->next->right = root->right; // Preserve right subtree
-                } 
-                else {
-                    // Normal BST deletion
-                    if (root->left == nullptr) {
-                        *root_ptr = root->right; 
-                    }
-                    else if (root->right == nullptr) {
-                        *root_ptr = root->left; 
-                    }
-                    else {
-                        PageInfo* successor = getSuccessor(root);
-
-                        // Crucial to update sucessors ptrs
-                        successor->left = root->left;
-                        successor->right = root->right;
-                        successor->next = root->next;
-
-                        root->approx_utilization = successor->approx_utilization;
-                        deletePageFromBucket(&root->right, successor);
-                    }
-                }
-                return;
+        *list = p;
+    }
+
+    static inline void pageListRemove(PageInfo** list, PageInfo* p) noexcept
+    {
+        if(p->prev != nullptr) {
+            p->prev->next = p->next;
+        }
+        else {
+            *list = p->next;
+        }
+
+        if(p->next != nullptr) {
+            p->next->prev = p->prev;
+        }
+
+        p->next = nullptr;
+        p->prev = nullptr;
+        p->pageset = PAGE_SET_NONE;
+    }
+
+    void insertPageInBucket(PageInfo** buckets, uint8_t pageset, size_t bucket_index, PageInfo* p) noexcept
+    {
+        p->pageset = pageset;
+        pageListPush(&buckets[bucket_index], p);
+    }
+
+    inline void insertPageInFilled(PageInfo* p) noexcept
+    {
+        p->pageset = PAGE_SET_FILLED;
+        pageListPush(&this->filled_pages, p);
+    }
+
+    //Take a page from the lowest non-empty bucket (pages within a bucket are not ordered)
+    PageInfo* findLowestUtilPage(PageInfo** buckets, int n) noexcept
+    {
+        for(int i = 0; i < n; i++) {
+            PageInfo* p = buckets[i];
+            if(p != nullptr) {
+                pageListRemove(&buckets[i], p);
+                return p;
             }
-    
-            //Handle node in the linked list
-            PageInfo* prev = root;
-            PageInfo* current = root->next;
-            while(current != nullptr) {
-                if(current == old_page) {
-                    prev->next = current->next;
-                    return;
+        }
+
+        return nullptr;
+    }
+
+    PageInfo* findFullestPage(PageInfo** buckets, int n) noexcept
+    {
+        for(int i = n - 1; i >= 0; i--) {
+            PageInfo* p = buckets[i];
+            if(p != nullptr) {
+                pageListRemove(&buckets[i], p);
+                return p;
+            }
+        }
+
+        return nullptr;
+    }
+
+    PageInfo* findLowestAddressPage(PageInfo** buckets, int n) noexcept
+    {
+        PageInfo* best = nullptr;
+        int bestbucket = 0;
+        for(int i = 0; i < n; i++) {
+            for(PageInfo* p = buckets[i]; p != nullptr; p = p->next) {
+                if(best == nullptr || p < best) {
+                    best = p;
+                    bestbucket = i;
                 }
-                prev = current;
-                current = current->next;
             }
-            return; //Node not found
         }
 
-        else if (root->approx_utilization > old_util) {  
-            deletePageFromBucket(&((*root_ptr)->left), old_page);
+        if(best != nullptr) {
+            pageListRemove(&buckets[bestbucket], best);
+        }
+        return best;
+    }
+
+    PageInfo* findPageByPolicy(PageInfo** buckets, int n, uint8_t policy) noexcept
+    {
+        if(policy == PAGE_SELECT_FULLEST_FIRST) {
+            return this->findFullestPage(buckets, n);
+        }
+        else if(policy == PAGE_SELECT_ADDRESS_ORDERED) {
+            return this->findLowestAddressPage(buckets, n);
         }
         else {
-            deletePageFromBucket(&((*root_ptr)->right), old_page);
+            return this->findLowestUtilPage(buckets, n);
         }
     }
 
-    inline PageInfo* getSuccessor(PageInfo* p) 
+    //Fullest bucket (high then low) whose pages have room for all of the remaining demand -- or the emptiest page if none does
+    PageInfo* findBestFitEvacuationPage() noexcept
     {
-        p = p->right;
-        while(p != nullptr && p->left != nullptr) {
-            p = p->left;
+        size_t entrycount = PageInfo::computeEntryCount(this->realsize);
+        size_t used = this->evac_slots_current + (this->evac_page != nullptr ? this->evac_page_startfree - this->evac_page->freecount : 0);
+        size_t demand = (this->evac_slots_last > used) ? (this->evac_slots_last - used) : 0;
+
+        //A page in bucket i of a set starting at utilization step stepbase has at least this many free slots
+        auto minfree = [entrycount](int stepbase, int i) { return (entrycount * (PAGE_UTIL_STEPS - (stepbase + i + 1))) / PAGE_UTIL_STEPS; };
+
+        for(int i = NUM_HIGH_UTIL_BUCKETS - 1; i >= 0; i--) {
+            if(this->high_utilization_buckets[i] != nullptr && minfree(NUM_LOW_UTIL_BUCKETS, i) >= demand) {
+                PageInfo* p = this->high_utilization_buckets[i];
+                pageListRemove(&this->high_utilization_buckets[i], p);
+                return p;
+            }
         }
-        return p;
+        for(int i = NUM_LOW_UTIL_BUCKETS - 1; i >= 0; i--) {
+            if(this->low_utilization_buckets[i] != nullptr && minfree(0, i) >= demand) {
+                PageInfo* p = this->low_utilization_buckets[i];
+                pageListRemove(&this->low_utilization_buckets[i], p);
+                return p;
+            }
+        }
+
+        PageInfo* page = this->findLowestUtilPage(this->low_utilization_buckets, NUM_LOW_UTIL_BUCKETS);
+        if(page == nullptr) {
+            page = this->findLowestUtilPage(this->high_utilization_buckets, NUM_HIGH_UTIL_BUCKETS);
+        }
+        return page;
     }
 
-    PageInfo* findLowestUtilPage(PageInfo** buckets, int n)
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Sweep unswept pages until one is usable as an alloc page (or as an evac page if forevac) -- the others are placed in their page sets as we go
+    PageInfo* sweepForUsablePage(bool forevac) noexcept
     {
-        for(int i = 0; i < n; i++) {
-            PageInfo* parent = nullptr;
-            PageInfo* cur = buckets[i];
-            if(cur == nullptr) continue;
-            
-            while(cur->left != nullptr) {
-                parent = cur;
-                cur = cur->left;
-            }
-            
-            if(cur == buckets[i]) { // If cur is root
-                if(cur->next != nullptr) {
-                    buckets[i] = cur->next;
-                    buckets[i]->left = cur->left;
-                    buckets[i]->right = cur->right;
-                } 
-                else {
-                    // Normal BST removal
-                    if(cur->right != nullptr) {
-                        buckets[i] = cur->right;
-                    } 
-                    else {
-                        buckets[i] = nullptr;
-                    }
-                }
-            } 
-            else { // If cur is not root
-                if(cur->right != nullptr) {
-                    parent->left = cur->right;
-                }
-                else {
-                    parent->left = nullptr;
-                }
+        while(this->unswept_pages != nullptr) {
+            PageInfo* p = this->unswept_pages;
+            this->unswept_pages = p->next;
+
+            p->rebuild();
+            p->pageset = PAGE_SET_NONE;
+
+            uint8_t n_class = this->getUtilClass(p);
+            if(n_class == PAGE_UTIL_CLASS_EMPTY || IS_LOW_UTIL_CLASS(n_class) || (forevac && IS_HIGH_UTIL_CLASS(n_class))) {
+                p->utilclass = n_class;
+                return p;
             }
-            
-            return cur;
+
+            this->processPage(p);
         }
+
         return nullptr;
     }
+#endif
 
     PageInfo* getFreshPageForAllocator() noexcept
     {
-        PageInfo* page = findLowestUtilPage(low_utilization_buckets, NUM_LOW_UTIL_BUCKETS);
+        PageInfo* page = this->findPageByPolicy(this->low_utilization_buckets, NUM_LOW_UTIL_BUCKETS, this->alloc_policy);
+#ifdef BSQ_GC_LAZY_SWEEP
         if(page == nullptr) {
-            page = GlobalPageGCManager::g_gc_page_manager.allocateFreshPage(this->allocsize, this->realsize);
+            page = this->sweepForUsablePage(false);
+        }
+#endif
+        if(page == nullptr) {
+            page = GlobalPageGCManager::g_gc_page_manager.allocateFreshPage(*this->owner, this->allocsize, this->realsize);
         }
 
         return page;
@@ -408,12 +941,23 @@ private:
 
     PageInfo* getFreshPageForEvacuation() noexcept
     {
-        PageInfo* page = findLowestUtilPage(high_utilization_buckets, NUM_HIGH_UTIL_BUCKETS);
+        PageInfo* page = nullptr;
+        if(this->evac_policy == PAGE_SELECT_BEST_FIT) {
+            page = this->findBestFitEvacuationPage();
+        }
+        else {
+            page = this->findPageByPolicy(this->high_utilization_buckets, NUM_HIGH_UTIL_BUCKETS, this->evac_policy);
+            if(page == nullptr) {
+                page = this->findPageByPolicy(this->low_utilization_buckets, NUM_LOW_UTIL_BUCKETS, this->evac_policy);
+            }
+        }
+#ifdef BSQ_GC_LAZY_SWEEP
         if(page == nullptr) {
-            page = findLowestUtilPage(low_utilization_buckets, NUM_LOW_UTIL_BUCKETS);
+            page = this->sweepForUsablePage(true);
         }
+#endif
         if(page == nullptr) {
-            page = GlobalPageGCManager::g_gc_page_manager.allocateFreshPage(this->allocsize, this->realsize);
+            page = GlobalPageGCManager::g_gc_page_manager.allocateFreshPage(*this->owner, this->allocsize, this->realsize);
         }
 
         return page;
@@ -423,89 +967,194 @@ private:
     {
         // If our evac page is full put directly on filled pages list
         if(this->evac_page != nullptr && this->evac_page->freecount == 0) {
-            this->evac_page->approx_utilization = 1.0f;
-            this->evac_page->next = this->filled_pages;
-            this->filled_pages = this->evac_page;
+            this->evac_page->bumpptr = this->evacbumpptr;
+            this->evac_page->utilclass = PAGE_UTIL_CLASS_FULL;
+            this->insertPageInFilled(this->evac_page);
         }
 
-        this->evac_page = this->getFreshPageForEvacuation();
-        this->evacfreelist = this->evac_page->freelist;
-    }
+        PageInfo* oldpage = this->evac_page;
+        PageInfo* page = this->getFreshPageForEvacuation();
+        if(oldpage != nullptr) {
+            this->evac_slots_current += this->evac_page_startfree - oldpage->freecount;
+        }
 
-public:
-    GCAllocator(uint16_t allocsize, uint16_t realsize, void (*collect)()) noexcept : freelist(nullptr), evacfreelist(nullptr), alloc_page(nullptr), evac_page(nullptr), allocsize(allocsize), realsize(realsize), pendinggc_pages(nullptr), low_utilization_buckets{}, high_utilization_buckets{}, filled_pages(nullptr), collectfp(collect) { }
+        this->evac_page = page;
+        this->evac_page_startfree = this->evac_page->freecount;
+        this->evacbumpptr = this->evac_page->bumpptr;
+        this->evacbumpend = this->evac_page->getBumpEnd();
 
-    inline size_t getAllocSize() const noexcept
+#ifdef BSQ_GC_ALLOC_BITMAP
+        this->evacbumpidx = this->evac_page->getBumpIndex();
+        this->evacscan = 0;
+#endif
+    }
+
+    //Put the evac page (if any) in its page set and reset the evac cursors
+    void releaseEvacuationPage() noexcept
     {
-        return this->allocsize;
+        if(this->evac_page != nullptr) {
+            this->evac_slots_current += this->evac_page_startfree - this->evac_page->freecount;
+            this->processPage(this->evac_page);
+
+            this->evac_page = nullptr;
+            this->evacbumpptr = nullptr;
+            this->evacbumpend = nullptr;
+        }
     }
 
-    // Simple check to see if a page is in alloc/evac/pendinggc pages
-    bool checkNonAllocOrGCPage(PageInfo* p) {
-        if(p == alloc_page || p == evac_page) {
-            return false;
+    //Slow path when the bump region of the alloc page is exhausted -- pop from the page freelist or get a new page
+    void* allocateFromFreelist() noexcept
+    {
+#ifdef BSQ_GC_ALLOC_BITMAP
+        size_t idx = (this->alloc_page != nullptr) ? this->alloc_page->findFreeSlot(this->allocscan) : 0;
+        if(this->alloc_page == nullptr || idx == this->alloc_page->entrycount) [[unlikely]] {
+            this->allocatorRefreshPage();
+
+            if(this->bumpptr != this->bumpend) {
+                void* entry = this->bumpptr;
+                this->bumpptr += this->realsize;
+                this->alloc_page->setYoungBit(this->bumpidx++);
+                return entry;
+            }
+
+            idx = this->alloc_page->findFreeSlot(this->allocscan);
+            GC_INVARIANT_CHECK(idx < this->alloc_page->entrycount);
         }
 
-        PageInfo* cur = pendinggc_pages;
-        while(cur != nullptr) {
-            if(cur == p) {
-                return false;
+        this->alloc_page->setYoungBit(idx);
+        return this->alloc_page->getFreelistEntryAtIndex(idx);
+#else
+        if(this->alloc_page == nullptr || this->alloc_page->freelist == nullptr) [[unlikely]] {
+            this->allocatorRefreshPage();
+
+            if(this->bumpptr != this->bumpend) {
+                void* entry = this->bumpptr;
+                this->bumpptr += this->realsize;
+                return entry;
             }
-            cur = cur->next;
         }
 
-        return true;
+        FreeListEntry* entry = this->alloc_page->freelist;
+        this->alloc_page->freelist = entry->next;
+        return entry;
+#endif
     }
 
-    // Used in case where a page's utilization changed and it isnt being grabbed for evac/alloc
-    void deleteOldPage(PageInfo* p) 
+    void* allocateEvacuationFromFreelist() noexcept
     {
-        int bucket_index = 0;
-        float old_util = p->approx_utilization;
+#ifdef BSQ_GC_ALLOC_BITMAP
+        size_t idx = (this->evac_page != nullptr) ? this->evac_page->findFreeSlot(this->evacscan) : 0;
+        if(this->evac_page == nullptr || idx == this->evac_page->entrycount) [[unlikely]] {
+            this->allocatorRefreshEvacuationPage();
 
-        if(IS_LOW_UTIL(old_util)) {
-            GET_BUCKET_INDEX(old_util, NUM_LOW_UTIL_BUCKETS, bucket_index, 0);
-            this->deletePageFromBucket(
-                &this->low_utilization_buckets[bucket_index], p);        
-        }
-        else if(IS_HIGH_UTIL(old_util)) {
-            GET_BUCKET_INDEX(old_util, NUM_HIGH_UTIL_BUCKETS, bucket_index, 1);
-            this->deletePageFromBucket(
-                &this->high_utilization_buckets[bucket_index], p);
+            if(this->evacbumpptr != this->evacbumpend) {
+                void* entry = this->evacbumpptr;
+                this->evacbumpptr += this->realsize;
+                this->evac_page->setOldBit(this->evacbumpidx++);
+                return entry;
+            }
+
+            idx = this->evac_page->findFreeSlot(this->evacscan);
+            GC_INVARIANT_CHECK(idx < this->evac_page->entrycount);
         }
 
-        // May want to make this traversal not O(n) worst case (sort?)
-        else {
-            PageInfo* cur = this->filled_pages;
-            PageInfo* prev = nullptr;
-            while(cur != nullptr && cur != p) {
-                prev = cur;
-                cur = cur->next;
-            }
+        this->evac_page->setOldBit(idx);
+        return this->evac_page->getFreelistEntryAtIndex(idx);
+#else
+        if(this->evac_page == nullptr || this->evac_page->freelist == nullptr) [[unlikely]] {
+            this->allocatorRefreshEvacuationPage();
 
-            if(prev == nullptr) {
-                this->filled_pages = cur->next;
+            if(this->evacbumpptr != this->evacbumpend) {
+                void* entry = this->evacbumpptr;
+                this->evacbumpptr += this->realsize;
+                return entry;
             }
-            else {
-                prev->next = cur->next;
-            }
-            p->next = nullptr;
-            p->left = nullptr;
-            p->right = nullptr;
         }
+
+        FreeListEntry* entry = this->evac_page->freelist;
+        this->evac_page->freelist = entry->next;
+        return entry;
+#endif
     }
 
-    inline void* allocate(TypeInfoBase* type)
+public:
+    GCAllocator(uint16_t allocsize, uint16_t realsize, void (*collect)()) noexcept : bumpptr(nullptr), bumpend(nullptr), evacbumpptr(nullptr), evacbumpend(nullptr), alloc_page(nullptr), evac_page(nullptr), allocsize(allocsize), realsize(realsize), pendinggc_pages(nullptr), low_utilization_buckets{}, high_utilization_buckets{}, filled_pages(nullptr), collectfp(collect), owner(nullptr), alloc_policy(PAGE_SELECT_LOWEST_UTIL), evac_policy(PAGE_SELECT_LOWEST_UTIL), evac_page_startfree(0), evac_slots_current(0), evac_slots_last(0), utilclass_shift(0), utilclass_table{} 
+    { 
+#ifdef BSQ_GC_LAZY_SWEEP
+        this->unswept_pages = nullptr;
+#endif
+        this->initializeUtilClassTable();
+    }
+
+    void setOwner(BSQMemoryTheadLocalInfo* tinfo) noexcept
     {
-        assert(type->type_size == this->allocsize);
+        this->owner = tinfo;
+    }
 
-        if(this->freelist == nullptr) [[unlikely]] {
-            this->allocatorRefreshPage();
+    void setPageSelectionPolicy(uint8_t allocpolicy, uint8_t evacpolicy) noexcept
+    {
+        GC_INVARIANT_CHECK(allocpolicy < PAGE_SELECT_POLICY_COUNT && evacpolicy < PAGE_SELECT_POLICY_COUNT);
+
+        this->alloc_policy = allocpolicy;
+        this->evac_policy = evacpolicy;
+    }
+
+    inline size_t getAllocSize() const noexcept
+    {
+        return this->allocsize;
+    }
+
+    inline uint8_t getAllocPolicy() const noexcept
+    {
+        return this->alloc_policy;
+    }
+
+    inline uint8_t getEvacPolicy() const noexcept
+    {
+        return this->evac_policy;
+    }
+
+    inline uint8_t getUtilClass(const PageInfo* p) const noexcept
+    {
+        uint32_t live = p->entrycount - p->freecount;
+        return this->utilclass_table[(live + (1u << this->utilclass_shift) - 1) >> this->utilclass_shift];
+    }
+
+    // Simple check to see if a page is in alloc/evac/pendinggc pages
+    inline bool checkNonAllocOrGCPage(PageInfo* p) const noexcept
+    {
+        return p->pageset == PAGE_SET_LOW_UTIL || p->pageset == PAGE_SET_HIGH_UTIL || p->pageset == PAGE_SET_FILLED;
+    }
+
+    // Used in case where a page's utilization changed and it isnt being grabbed for evac/alloc
+    void deleteOldPage(PageInfo* p) noexcept
+    {
+        if(p->pageset == PAGE_SET_LOW_UTIL) {
+            pageListRemove(&this->low_utilization_buckets[p->utilclass - PAGE_UTIL_CLASS_LOW(0)], p);
         }
+        else if(p->pageset == PAGE_SET_HIGH_UTIL) {
+            pageListRemove(&this->high_utilization_buckets[p->utilclass - PAGE_UTIL_CLASS_HIGH(0)], p);
+        }
+        else {
+            GC_INVARIANT_CHECK(p->pageset == PAGE_SET_FILLED);
+            pageListRemove(&this->filled_pages, p);
+        }
+    }
 
-        void* entry = this->freelist;
-        this->freelist = this->freelist->next;
-        this->alloc_page->freelist = this->alloc_page->freelist->next;
+    inline void* allocate(TypeInfoBase* type)
+    {
+        assert(type->type_size <= this->allocsize);
+        ENSURE_TYPE_LAYOUT(type);
+
+        void* entry;
+        if(this->bumpptr != this->bumpend) [[likely]] {
+            entry = this->bumpptr;
+            this->bumpptr += this->realsize;
+            ALLOC_BITMAP_OP(this->alloc_page->setYoungBit(this->bumpidx++));
+        }
+        else {
+            entry = this->allocateFromFreelist();
+        }
             
         this->alloc_page->freecount--;
 
@@ -517,15 +1166,17 @@ public:
 
     inline void* allocateEvacuation(TypeInfoBase* type)
     {
-        assert(type->type_size == this->allocsize);
+        assert(type->type_size <= this->allocsize);
 
-        if(this->evacfreelist == nullptr) [[unlikely]] {
-            this->allocatorRefreshEvacuationPage();
+        void* entry;
+        if(this->evacbumpptr != this->evacbumpend) [[likely]] {
+            entry = this->evacbumpptr;
+            this->evacbumpptr += this->realsize;
+            ALLOC_BITMAP_OP(this->evac_page->setOldBit(this->evacbumpidx++));
+        }
+        else {
+            entry = this->allocateEvacuationFromFreelist();
         }
-
-        void* entry = this->evacfreelist;
-        this->evacfreelist = this->evacfreelist->next;
-        this->evac_page->freelist = this->evac_page->freelist->next;
 
         this->evac_page->freecount--;
 
@@ -535,6 +1186,153 @@ public:
         return SETUP_ALLOC_LAYOUT_GET_OBJ_PTR(entry);
     }
 
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Sweep up to maxpages unswept pages into their page sets (empty ones go back to the global pool) -- for idle points so cold pages can be decommitted
+    size_t sweepUnsweptPages(size_t maxpages) noexcept
+    {
+        size_t swept = 0;
+        while(this->unswept_pages != nullptr && swept < maxpages) {
+            PageInfo* p = this->unswept_pages;
+            this->unswept_pages = p->next;
+
+            p->rebuild();
+            p->pageset = PAGE_SET_NONE;
+            this->processPage(p);
+
+            swept++;
+        }
+
+        return swept;
+    }
+#endif
+
+    //If enough pages would be freed unlink the sparsest pages for old space compaction (at most BSQ_COMPACTION_MAX_BYTES of live objects on them)
+    //returns them linked through next
+    PageInfo* selectCompactionPages() noexcept
+    {
+        size_t sparsepages = 0;
+        size_t sparselive = 0;
+        for(int i = 0; i < BSQ_COMPACTION_SPARSE_BUCKETS; i++) {
+            for(PageInfo* p = this->low_utilization_buckets[i]; p != nullptr; p = p->next) {
+                sparsepages++;
+                sparselive += p->entrycount - p->freecount;
+            }
+        }
+
+        size_t entrycount = PageInfo::computeEntryCount(this->realsize);
+        if(sparsepages - ((sparselive + entrycount - 1) / entrycount) < BSQ_COMPACTION_MIN_RECLAIM_PAGES) {
+            return nullptr;
+        }
+
+        size_t maxmove = BSQ_COMPACTION_MAX_BYTES / this->realsize;
+        size_t movecount = 0;
+        PageInfo* sources = nullptr;
+        for(int i = 0; i < BSQ_COMPACTION_SPARSE_BUCKETS; i++) {
+            PageInfo* p = this->low_utilization_buckets[i];
+            while(p != nullptr) {
+                PageInfo* next = p->next;
+
+                size_t live = p->entrycount - p->freecount;
+                if(movecount + live <= maxmove) {
+                    pageListRemove(&this->low_utilization_buckets[i], p);
+                    p->pageset = PAGE_SET_COMPACTING;
+                    p->next = sources;
+                    sources = p;
+
+                    movecount += live;
+                }
+
+                p = next;
+            }
+        }
+
+        return sources;
+    }
+
+    //Move every unpinned (non root) object off a page selected for compaction -- the old slots hold the new address until the references are fixed
+    //returns the number of objects moved
+    size_t evacuateCompactionPage(PageInfo* p) noexcept
+    {
+        size_t moved = 0;
+        size_t bumpidx = p->getBumpIndex();
+        for(size_t i = 0; i < bumpidx; i++) {
+            MetaData* meta = p->getMetaEntryAtIndex(i);
+            void* obj = (uint8_t*)meta + sizeof(MetaData);
+#ifdef BSQ_GC_ALLOC_BITMAP
+            //Dead young slots keep their headers (rebuild only clears the young bits) so the old bits are what say an object is live
+            if(!p->isSlotInUse(i) || GC_IS_ROOT(obj)) {
+                continue;
+            }
+#else
+            if(!meta->isalloc || GC_IS_ROOT(obj)) {
+                continue;
+            }
+#endif
+
+            void* newobj = this->allocateEvacuation(meta->type);
+            xmem_copy(obj, newobj, meta->type->slot_size);
+            GC_REF_COUNT(newobj) = meta->ref_count;
+
+            ALLOC_BITMAP_OP(p->clearOldBit(i));
+            FORWARD_METADATA_FOR_OBJECT(meta, newobj);
+            moved++;
+        }
+
+        return moved;
+    }
+
+    //Give a worker evacuation buffer a new page (a full old one goes to the filled pages)
+    void refillEvacBuffer(EvacBuffer& buf) noexcept
+    {
+        if(buf.page != nullptr) {
+            GC_INVARIANT_CHECK(buf.page->freecount == 0);
+            this->evac_slots_current += buf.startfree;
+
+            buf.page->bumpptr = buf.bumpptr;
+            buf.page->utilclass = PAGE_UTIL_CLASS_FULL;
+            this->insertPageInFilled(buf.page);
+        }
+
+        buf.page = this->getFreshPageForEvacuation();
+        buf.startfree = buf.page->freecount;
+        buf.bumpptr = buf.page->bumpptr;
+        buf.bumpend = buf.page->getBumpEnd();
+        buf.realsize = this->realsize;
+#ifdef BSQ_GC_ALLOC_BITMAP
+        buf.bumpidx = buf.page->getBumpIndex();
+        buf.scan = 0;
+#endif
+    }
+
+    //Put the page of a worker evacuation buffer (if any) in its page set once the worker is done
+    void releaseEvacBuffer(EvacBuffer& buf) noexcept
+    {
+        if(buf.page != nullptr) {
+            this->evac_slots_current += buf.startfree - buf.page->freecount;
+
+            buf.page->bumpptr = buf.bumpptr;
+            this->processPage(buf.page);
+
+            buf.page = nullptr;
+            buf.bumpptr = nullptr;
+            buf.bumpend = nullptr;
+        }
+    }
+
+    //Once references are fixed rebuild the compacted pages (only pinned objects are left) and put them and the evac page back in the page sets
+    void finishCompaction(PageInfo* sources) noexcept;
+
+    //Write the bump cursors back to the alloc/evac pages so that conservative root checks and rebuild see every handed out slot
+    inline void flushBumpCursors() noexcept
+    {
+        if(this->alloc_page != nullptr) {
+            this->alloc_page->bumpptr = this->bumpptr;
+        }
+        if(this->evac_page != nullptr) {
+            this->evac_page->bumpptr = this->evacbumpptr;
+        }
+    }
+
 #ifdef MEM_STATS
     void updateMemStats();
 #else
@@ -544,9 +1342,34 @@ public:
     //Take a page (that may be in of the page sets -- or may not -- if it is a alloc or evac page) and move it to the appropriate page set
     void processPage(PageInfo* p) noexcept;
 
-    //process all the pending gc pages, the current alloc page, and evac page -- reset for next round
+    //process all the pending gc pages, the current alloc page, and evac page -- reset for next round (with BSQ_GC_LAZY_SWEEP the alloc and pending pages are only parked for sweeping)
     void processCollectorPages() noexcept;
 
     //May call collection, needs definition in cpp file to prevent cyclic dependicies in fetching gtl_info
     void allocatorRefreshPage() noexcept;
-};
\ No newline at end of file
+};
+
+//Allocator for objects larger than the biggest size class -- each object gets its own span and is never moved
+class GCLargeObjectAllocator
+{
+private:
+    PageInfo* young_spans; //spans allocated since the last collection
+    uint64_t live_bytes;
+
+public:
+    GCLargeObjectAllocator() noexcept : young_spans(nullptr), live_bytes(0) { }
+
+    inline uint64_t getLiveBytes() const noexcept
+    {
+        return this->live_bytes;
+    }
+
+    //May call collection, needs definition in cpp file to prevent cyclic dependicies in fetching gtl_info
+    void* allocate(TypeInfoBase* type) noexcept;
+
+    //Unmap the span of a dead (old) large object
+    void release(PageInfo* span) noexcept;
+
+    //Young large objects that were not promoted during the collection are dead -- release them and reset the young list
+    void processCollectorSpans() noexcept;
+};
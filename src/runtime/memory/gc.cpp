@@ -9,6 +9,8 @@
 #define INC_REF_COUNT(O) (++GC_REF_COUNT(O))
 #define DEC_REF_COUNT(O) (--GC_REF_COUNT(O))
 
+typedef PrefetchQueue<void**, BSQ_GC_PREFETCH_DISTANCE> SlotPrefetchQueue;
+
 void reprocessPageInfo(PageInfo* page, BSQMemoryTheadLocalInfo& tinfo) noexcept
 {
     // This should not be called on pages that are (1) active allocators or evacuators or (2) pending collection pages
@@ -19,6 +21,14 @@ void reprocessPageInfo(PageInfo* page, BSQMemoryTheadLocalInfo& tinfo) noexcept
     }
 }
 
+// A root that is still referenced by other objects is freed by the decrement that drops its last reference instead
+inline void pushDroppedRoot(void* oldroot, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    if(GC_REF_COUNT(oldroot) == 0) {
+        tinfo.pending_decs.push_back(oldroot);
+    }
+}
+
 void computeDeadRootsForDecrement(BSQMemoryTheadLocalInfo& tinfo) noexcept
 {
     // First we need to sort the roots we find
@@ -32,7 +42,7 @@ void computeDeadRootsForDecrement(BSQMemoryTheadLocalInfo& tinfo) noexcept
         
         if(roots_idx >= tinfo.roots_count) {
             // Was dropped from roots
-            tinfo.pending_decs.push_back(cur_oldroot);
+            pushDroppedRoot(cur_oldroot, tinfo);
             oldroots_idx++;
         }
         else {
@@ -43,7 +53,7 @@ void computeDeadRootsForDecrement(BSQMemoryTheadLocalInfo& tinfo) noexcept
                 roots_idx++;
             } else if(cur_oldroot < cur_root) {
                 // Was dropped from roots
-                tinfo.pending_decs.push_back(cur_oldroot);
+                pushDroppedRoot(cur_oldroot, tinfo);
                 oldroots_idx++;
             } else {
                 // In both lists
@@ -56,52 +66,24 @@ void computeDeadRootsForDecrement(BSQMemoryTheadLocalInfo& tinfo) noexcept
     tinfo.old_roots_count = 0;
 }
 
-bool pageNeedsMoved(float old_util, float new_util)
+bool pageNeedsMoved(uint8_t old_class, uint8_t new_class)
 {
     // Case where page hasnt been processed before
-    if (old_util > 1.1f) {
+    if(old_class == PAGE_UTIL_CLASS_UNSET) {
         return false;
     }
 
-    // Handle empty page case
-    if (new_util < 0.01f && old_util > 0.01f) {
-        return true;
-    }
-
-    const bool was_low_util = IS_LOW_UTIL(old_util);
-    const bool now_low_util = IS_LOW_UTIL(new_util);
-    if (was_low_util != now_low_util) {
-        return true;
-    }
-
-    const bool was_high_util = IS_HIGH_UTIL(old_util);
-    const bool now_high_util = IS_HIGH_UTIL(new_util);
-    if (was_high_util != now_high_util) {
-        return true;
-    }
-
-    const bool was_full = IS_FULL(old_util);
-    const bool now_full = IS_FULL(new_util);
-    if (was_full != now_full) {
-        return true;
-    }
+    // Each class is exactly one page set (or bucket) so any change means the page moves
+    return old_class != new_class;
+}
 
-    if (now_low_util) {
-        int old_bucket = -1; 
-        int new_bucket = -1;
-        GET_BUCKET_INDEX(old_util, NUM_LOW_UTIL_BUCKETS, old_bucket, 0);
-        GET_BUCKET_INDEX(new_util, NUM_LOW_UTIL_BUCKETS, new_bucket, 0);
-        return old_bucket != new_bucket;
-    } 
-    else if (now_high_util){
-        int old_bucket = -1; 
-        int new_bucket = -1;
-        GET_BUCKET_INDEX(old_util, NUM_HIGH_UTIL_BUCKETS, old_bucket, 1);
-        GET_BUCKET_INDEX(new_util, NUM_HIGH_UTIL_BUCKETS, new_bucket, 1);
-        return old_bucket != new_bucket;
-    }
-    else {
-        return false;
+// Drop the ref a dead object held on a child -- if that was the last one (and the child is not a root) the child is dead too
+inline void decrementChild(void* child, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    //If this object is a root we dont want to explore its children (this deletes a subtree who is still alive)
+    if(DEC_REF_COUNT(child) == 0 && !GC_IS_ROOT(child)) {
+        PageInfo::extractPageFromPointer(child)->pending_decs_count++;
+        tinfo.pending_decs.push_back(child);
     }
 }
 
@@ -114,7 +96,20 @@ void processDecrements(BSQMemoryTheadLocalInfo& tinfo) noexcept
     GC_REFCT_LOCK_ACQUIRE();
 
     size_t deccount = 0;
-    while(!tinfo.pending_decs.isEmpty() && (deccount < tinfo.max_decrement_count)) {
+    PageInfo* dead_spans = nullptr;
+    PrefetchQueue<void*, BSQ_GC_PREFETCH_DISTANCE> children;
+    void* child = nullptr;
+    while(deccount < tinfo.max_decrement_count) {
+        if(tinfo.pending_decs.isEmpty()) {
+            // Children still waiting in the prefetch queue may free more objects
+            if(!children.pop(child)) {
+                break;
+            }
+
+            decrementChild(child, tinfo);
+            continue;
+        }
+
         void* obj = (void**)tinfo.pending_decs.pop_front();
         deccount++;
 
@@ -126,33 +121,31 @@ void processDecrements(BSQMemoryTheadLocalInfo& tinfo) noexcept
         // Decrement ref counts of objects this object points to
         const TypeInfoBase* type_info = GC_TYPE(obj);
 
-        if(type_info->ptr_mask != LEAF_PTR_MASK) {
-            const char* ptr_mask = type_info->ptr_mask;
-            void** slots = (void**)obj;
-            while(*ptr_mask != '\0') {
-                char mask = *(ptr_mask++);
-
-                if(*slots != nullptr) {
-                    //If this object is a root we dont want to explore its children (this deletes a subtree who is still alive)
-                    if(mask == PTR_MASK_PTR && DEC_REF_COUNT(*slots) == 0  && !GC_IS_ROOT(*slots)) {
-                        PageInfo::extractPageFromPointer(*slots)->pending_decs_count++;
-                        tinfo.pending_decs.push_back(*slots);
-                    }
-                    if(PTR_MASK_STRING_AND_SLOT_PTR_VALUED(mask, *slots) && DEC_REF_COUNT(*slots) == 0 && !GC_IS_ROOT(*slots)) {
-                        PageInfo::extractPageFromPointer(*slots)->pending_decs_count++;
-                        tinfo.pending_decs.push_back(*slots);
-                    }
-                }
-
-                slots++;
+        visitPointerSlots(type_info, (void**)obj, [&](void** slot) {
+            __builtin_prefetch(GC_GET_META_DATA_ADDR(*slot), 1);
+            if(children.push(*slot, child)) {
+                decrementChild(child, tinfo);
             }
-        }
+        });
 
-        // Put object onto its pages freelist by masking to the page itself then pushing to front of list 
+        // Large objects own their whole span -- unmap it once we are done with this batch
         PageInfo* objects_page = PageInfo::extractPageFromPointer(obj);
-        FreeListEntry* entry = (FreeListEntry*)((uint8_t*)obj - sizeof(MetaData));
+        if(objects_page->isLargeObjectPage()) [[unlikely]] {
+            GC_IS_ALLOCATED(obj) = false;
+
+            objects_page->next = dead_spans;
+            dead_spans = objects_page;
+            continue;
+        }
+
+#ifdef BSQ_GC_ALLOC_BITMAP
+        objects_page->clearOldBit(PageInfo::getIndexForObjectInPage(obj));
+#else
+        // Put object onto its pages freelist by masking to the page itself then pushing to front of list (the entry is the slot start, before any canary)
+        FreeListEntry* entry = objects_page->getFreelistEntryAtIndex(PageInfo::getIndexForObjectInPage(obj));
         entry->next = objects_page->freelist;
         objects_page->freelist = entry;
+#endif
 
         // Need to make sure pending decs count is not 0 already, this prevents us from
         // decrementing dec count for the root object and wrapping to max uint16
@@ -164,23 +157,40 @@ void processDecrements(BSQMemoryTheadLocalInfo& tinfo) noexcept
         GC_IS_ALLOCATED(obj) = false;
 
         objects_page->freecount++;
-        tinfo.decremented_pages[tinfo.decremented_pages_index++] = objects_page;
+        if(!objects_page->indecremented) {
+            objects_page->indecremented = true;
+            tinfo.decremented_pages[tinfo.decremented_pages_index++] = objects_page;
+        }
+    }
+
+    while(children.pop(child)) {
+        decrementChild(child, tinfo);
     }
 
     for(int i = 0; i < tinfo.decremented_pages_index; i++) {        
         // We only want to move pages without pending decs
         // We can think of these pages as stable
         PageInfo* p = tinfo.decremented_pages[i];
+        p->indecremented = false;
+        GC_INVARIANT_CHECK(p->pageset != PAGE_SET_NONE || p->utilclass != PAGE_UTIL_CLASS_EMPTY); //never a page that is already back in the pool
+
         if(p->pending_decs_count > 0) {
             continue;
         }
 
-        if(pageNeedsMoved(p->approx_utilization, CALC_APPROX_UTILIZATION(p))) {
+        // A page that is now empty goes back to the page pool (where another thread may decommit it) so each page is only visited once
+        if(pageNeedsMoved(p->utilclass, tinfo.getAllocatorForPageSize(p)->getUtilClass(p))) {
             reprocessPageInfo(p, tinfo);
         }
     }
     tinfo.decremented_pages_index = 0;
 
+    while(dead_spans != nullptr) {
+        PageInfo* next = dead_spans->next;
+        tinfo.large_alloc.release(dead_spans);
+        dead_spans = next;
+    }
+
     GC_REFCT_LOCK_RELEASE();
 
     //
@@ -199,34 +209,240 @@ void processDecrements(BSQMemoryTheadLocalInfo& tinfo) noexcept
 #endif
 }
 
-// Update pointers using forward table
-void updatePointers(void** obj, const BSQMemoryTheadLocalInfo& tinfo) noexcept
+// Forward a slot (if its target was evacuated) and count the reference -- parallel fixups count with an atomic add (workers can share a target)
+template <bool ATOMIC_REFS = false>
+inline void updateSlot(void** slot) noexcept
+{
+    if(GC_IS_FORWARDED(*slot)) {
+        *slot = GC_FORWARD_PTR(*slot); 
+    }
+
+    if constexpr(ATOMIC_REFS) {
+        __atomic_fetch_add(&GC_REF_COUNT(*slot), 1, __ATOMIC_RELAXED);
+    }
+    else {
+        INC_REF_COUNT(*slot);
+    }
+}
+
+// Update pointers to forwarded objects -- the slots go through the prefetch queue so the caller must drain it (with updateSlot) when done
+template <bool ATOMIC_REFS = false>
+void updatePointers(void** obj, SlotPrefetchQueue& fixups) noexcept
 {
     TypeInfoBase* type_info = GC_TYPE(obj);
 
-    if(type_info->ptr_mask != LEAF_PTR_MASK) {
-        const char* ptr_mask = type_info->ptr_mask;
-        void** slots = (void**)obj;
+    visitPointerSlots(type_info, obj, [&](void** slot) {
+        __builtin_prefetch(GC_GET_META_DATA_ADDR(*slot), 1);
 
-        while(*ptr_mask != '\0') {
-            char mask = *(ptr_mask++);
+        void** ready = nullptr;
+        if(fixups.push(slot, ready)) {
+            updateSlot<ATOMIC_REFS>(ready);
+        }
+    });
+}
 
-            if(*slots != nullptr) {
-                if((mask == PTR_MASK_PTR) | PTR_MASK_STRING_AND_SLOT_PTR_VALUED(mask, *slots)) {
-                    uint32_t fwd_index = GC_FWD_INDEX(*slots);
-                    if(fwd_index != MAX_FWD_INDEX) {
-                        *slots = tinfo.forward_table[fwd_index]; 
-                    }
-                    INC_REF_COUNT(*slots);
-                }
+template <bool ATOMIC_REFS = false>
+void drainSlotFixups(SlotPrefetchQueue& fixups) noexcept
+{
+    void** slot = nullptr;
+    while(fixups.pop(slot)) {
+        updateSlot<ATOMIC_REFS>(slot);
+    }
+}
+
+// Roots (pinned) and large objects are never copied -- fix their pointers and promote them where they are
+void promoteYoungInPlace(void* obj, BSQMemoryTheadLocalInfo& tinfo, SlotPrefetchQueue& fixups) noexcept
+{
+    updatePointers((void**)obj, fixups);
+
+    MetaData* meta = GC_GET_META_DATA_ADDR(obj);
+    GC_CLEAR_YOUNG_MARK(meta);
+
+    PageInfo* page = PageInfo::extractPageFromPointer(obj);
+    if(page->isLargeObjectPage()) {
+        GC_CLEAR_MARK(meta);
+    }
+#ifdef BSQ_GC_ALLOC_BITMAP
+    else {
+        page->setOldBit(PageInfo::getIndexForObjectInPage(obj));
+    }
+#endif
+}
+
+void* evacuateYoungObject(void* obj, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    TypeInfoBase* type_info = GC_TYPE(obj);
+    GCAllocator* gcalloc = tinfo.getAllocatorForPageSize(PageInfo::extractPageFromPointer(obj));
+    GC_INVARIANT_CHECK(gcalloc != nullptr);
+
+    void* newobj = gcalloc->allocateEvacuation(type_info);
+    xmem_copy(obj, newobj, type_info->slot_size);
+
+    FORWARD_METADATA_FOR_OBJECT(GC_GET_META_DATA_ADDR(obj), newobj);
+
+    return newobj;
+}
+
+// Copy (or pin) every object on a marked list -- the final address of each goes on pending_roots for the pointer fixup pass
+void evacuateMarkedYoungList(ArrayList<void*>& young, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    while(!young.isEmpty()) {
+        void* obj = young.pop_front();
+        GC_INVARIANT_CHECK(GC_IS_YOUNG(obj) && GC_IS_MARKED(obj));
+
+        if(GC_IS_ROOT(obj) || PageInfo::extractPageFromPointer(obj)->isLargeObjectPage()) {
+            tinfo.pending_roots.push_back(obj);
+        }
+        else {
+            tinfo.pending_roots.push_back(evacuateYoungObject(obj, tinfo));
+        }
+    }
+}
+
+// Move every marked object (the worker lists and pending_young) into evac_objects -- the pool threads are parked so this needs no synchronization
+void flattenMarkedYoung(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    size_t count = 0;
+    for(size_t i = 0; i <= tinfo.mark_worker_count; i++) {
+        ArrayList<void*>& young = (i < tinfo.mark_worker_count) ? tinfo.mark_workers[i].pending_young : tinfo.pending_young;
+        while(!young.isEmpty()) {
+            if(count == tinfo.evac_objects_capacity) [[unlikely]] {
+                size_t oldbytes = tinfo.evac_objects_capacity * sizeof(void*);
+                size_t newbytes = (oldbytes == 0) ? BSQ_OS_PAGE_SIZE : 2 * oldbytes;
+
+                void* objects = (oldbytes == 0) ? mmap(NULL, newbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0) : mremap(tinfo.evac_objects, oldbytes, newbytes, MREMAP_MAYMOVE);
+                assert(objects != MAP_FAILED);
+
+                tinfo.evac_objects = (void**)objects;
+                tinfo.evac_objects_capacity = newbytes / sizeof(void*);
             }
 
-            slots++;
+            tinfo.evac_objects[count++] = young.pop_front();
         }
     }
+
+    tinfo.evac_objects_count = count;
+    tinfo.evac_cursor.store(0, std::memory_order_relaxed);
+}
+
+// Claim up to BSQ_EVAC_CHUNK_OBJECTS marked objects -- every marked object is in exactly one claimed range so no two workers ever copy the same object
+inline size_t claimEvacuationChunk(BSQMemoryTheadLocalInfo& tinfo, void**& chunk) noexcept
+{
+    size_t start = tinfo.evac_cursor.fetch_add(BSQ_EVAC_CHUNK_OBJECTS, std::memory_order_relaxed);
+    if(start >= tinfo.evac_objects_count) {
+        return 0;
+    }
+
+    chunk = tinfo.evac_objects + start;
+    return std::min(BSQ_EVAC_CHUNK_OBJECTS, tinfo.evac_objects_count - start);
 }
 
-// Move non root young objects to evacuation page (as needed) then forward pointers and inc ref counts
+// Copy into the private evacuation buffer of the worker -- only a refill takes the lock (the size class allocators are shared)
+void* evacuateYoungObjectParallel(void* obj, MarkWorker* w) noexcept
+{
+    BSQMemoryTheadLocalInfo* tinfo = w->tinfo;
+    TypeInfoBase* type_info = GC_TYPE(obj);
+
+    size_t cidx = getSizeClassIndex(PageInfo::extractPageFromPointer(obj)->allocsize);
+    EvacBuffer& buf = w->evac_buffers[cidx];
+
+    void* newobj = buf.allocate(type_info);
+    if(newobj == nullptr) [[unlikely]] {
+        assert(mtx_lock(&tinfo->evac_lock) == thrd_success);
+        tinfo->g_gcallocs[cidx]->refillEvacBuffer(buf);
+        assert(mtx_unlock(&tinfo->evac_lock) == thrd_success);
+
+        newobj = buf.allocate(type_info);
+    }
+    xmem_copy(obj, newobj, type_info->slot_size);
+
+    FORWARD_METADATA_FOR_OBJECT(GC_GET_META_DATA_ADDR(obj), newobj);
+
+    return newobj;
+}
+
+int evacWorkerMain(void* arg) noexcept
+{
+    MarkWorker* w = (MarkWorker*)arg;
+    BSQMemoryTheadLocalInfo& tinfo = *w->tinfo;
+
+    void** chunk = nullptr;
+    size_t count = 0;
+    while((count = claimEvacuationChunk(tinfo, chunk)) != 0) {
+        for(size_t i = 0; i < count; i++) {
+            void* obj = chunk[i];
+            GC_INVARIANT_CHECK(GC_IS_YOUNG(obj) && GC_IS_MARKED(obj));
+
+            if(GC_IS_ROOT(obj) || PageInfo::extractPageFromPointer(obj)->isLargeObjectPage()) {
+                w->pinned.push_back(obj);
+            }
+            else {
+                w->evacuated.push_back(evacuateYoungObjectParallel(obj, w));
+            }
+        }
+    }
+
+    // Every object has to be at its final address before any pointer is fixed
+    tinfo.evac_copying_workers.fetch_sub(1, std::memory_order_acq_rel);
+    while(tinfo.evac_copying_workers.load(std::memory_order_acquire) != 0) {
+        thrd_yield();
+    }
+
+    // The emptied pending_young of the worker keeps the survivors of an incremental cycle for releaseFloatingYoung
+    SlotPrefetchQueue fixups;
+    while(!w->evacuated.isEmpty()) {
+        void* obj = w->evacuated.pop_front();
+        updatePointers<true>((void**)obj, fixups);
+
+        if(tinfo.incremental_mark_active) {
+            w->pending_young.push_back(obj);
+        }
+    }
+    drainSlotFixups<true>(fixups);
+
+    return 0;
+}
+
+// Copy and fix the marked objects with tinfo.mark_worker_count GC threads -- the pinned objects are left on pending_roots for the serial fixup loop
+void parallelEvacuateYoung(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    size_t nworkers = tinfo.mark_worker_count;
+    for(size_t i = 0; i < nworkers; i++) {
+        MarkWorker* w = &tinfo.mark_workers[i];
+        w->evacuated.initialize();
+        w->pinned.initialize();
+    }
+
+    flattenMarkedYoung(tinfo);
+    tinfo.evac_copying_workers.store(nworkers, std::memory_order_release);
+
+    tinfo.startGCWorkers(evacWorkerMain, nworkers);
+    evacWorkerMain(&tinfo.mark_workers[0]);
+    tinfo.waitGCWorkers();
+
+    for(size_t i = 0; i < nworkers; i++) {
+        MarkWorker* w = &tinfo.mark_workers[i];
+        for(size_t cidx = 0; cidx < BSQ_SIZE_CLASS_COUNT; cidx++) {
+            if(w->evac_buffers[cidx].page != nullptr) {
+                tinfo.g_gcallocs[cidx]->releaseEvacBuffer(w->evac_buffers[cidx]);
+            }
+        }
+
+        while(!w->pinned.isEmpty()) {
+            tinfo.pending_roots.push_back(w->pinned.pop_front());
+        }
+        while(!w->pending_young.isEmpty()) {
+            tinfo.pending_young.push_back(w->pending_young.pop_front());
+        }
+
+        w->evacuated.clear();
+        w->pinned.clear();
+        w->pending_young.clear();
+    }
+}
+
+// Move non root young objects to evacuation page (as needed) then forward pointers and inc ref counts.
+// The marked lists are in no particular order (a parent can come before its children or a sibling that points to them) so everything is copied first and then fixed.
 void processMarkedYoungObjects(BSQMemoryTheadLocalInfo& tinfo) noexcept 
 {
 #ifdef MEM_STATS
@@ -234,28 +450,36 @@ void processMarkedYoungObjects(BSQMemoryTheadLocalInfo& tinfo) noexcept
 #endif
     GC_REFCT_LOCK_ACQUIRE();
 
-    while(!tinfo.pending_young.isEmpty()) {
-        void* obj = tinfo.pending_young.pop_front();
-        TypeInfoBase* type_info = GC_TYPE(obj);
-        GC_INVARIANT_CHECK(GC_IS_YOUNG(obj) && GC_IS_MARKED(obj));
+    tinfo.pending_roots.initialize();
+
+    if(tinfo.mark_worker_count > 1) {
+        parallelEvacuateYoung(tinfo);
+    }
+    else {
+        evacuateMarkedYoungList(tinfo.pending_young, tinfo);
+    }
+
+    // Everything is at its final address now -- anything still young is promoted in place
+    SlotPrefetchQueue fixups;
+    while(!tinfo.pending_roots.isEmpty()) {
+        void* obj = tinfo.pending_roots.pop_front();
 
-        if(GC_IS_ROOT(obj)) {
-            updatePointers((void**)obj, tinfo);
-            GC_CLEAR_YOUNG_MARK(GC_GET_META_DATA_ADDR(obj));
+        if(GC_IS_YOUNG(obj)) {
+            promoteYoungInPlace(obj, tinfo, fixups);
         }
         else {
-            // If we are not a root we want to evacuate
-            GCAllocator* gcalloc = tinfo.getAllocatorForPageSize(PageInfo::extractPageFromPointer(obj));
-            GC_INVARIANT_CHECK(gcalloc != nullptr);
-        
-            void* newobj = gcalloc->allocateEvacuation(type_info);
-            xmem_copy(obj, newobj, type_info->slot_size);
-            updatePointers((void**)newobj, tinfo);
+            updatePointers((void**)obj, fixups);
+        }
 
-            RESET_METADATA_FOR_OBJECT(GC_GET_META_DATA_ADDR(obj), (uint32_t)tinfo.forward_table_index);
-            tinfo.forward_table[tinfo.forward_table_index++] = newobj;
+        // Keep the survivors of an incremental cycle for releaseFloatingYoung (their counts are only complete once all fixups are done)
+        if(tinfo.incremental_mark_active) {
+            tinfo.pending_young.push_back(obj);
         }
     }
+    tinfo.pending_roots.clear();
+
+    // The forward pointers the queued slots need stay in the dead headers until the young pages are rebuilt
+    drainSlotFixups(fixups);
 
     GC_REFCT_LOCK_RELEASE();
 
@@ -271,36 +495,60 @@ void processMarkedYoungObjects(BSQMemoryTheadLocalInfo& tinfo) noexcept
 #endif
 }
 
-void checkPotentialPtr(void* addr, BSQMemoryTheadLocalInfo& tinfo) noexcept
+// Metadata of the object a possible pointer points into -- nullptr if it is not in a slot that is in use
+MetaData* resolvePotentialPtr(void* addr) noexcept
 {
-    // Make sure our page is in pagetable, our address is not a page itself,
-    // or a pointer into the page's metadata
-    uintptr_t page_offset = (uintptr_t)addr & 0xFFF;
-    if(GlobalPageGCManager::g_gc_page_manager.pagetable_query(addr)
-        && !(page_offset < sizeof(PageInfo))
+    // Make sure our page is in pagetable and the address is in the handed out slots of the page
+    // (not the page header and not in the untouched bump region)
+    PageInfo* page = GlobalPageGCManager::g_gc_page_manager.pagetable_lookup(addr);
+    if(page == nullptr
+        || (uint8_t*)addr < page->data
+        || page->bumpptr <= (uint8_t*)addr
+#ifdef BSQ_GC_ALLOC_BITMAP
+        //Metadata of dead young slots is never reset so the bitmaps are what say if a slot is in use
+        || !(page->isLargeObjectPage() || page->isSlotInUse(PageInfo::getIndexForObjectInPage(addr)))
+#endif
     ) {
-        MetaData* meta = PageInfo::getObjectMetadataAligned(addr);
-        void* obj = (void*)((uint8_t*)meta + sizeof(MetaData));
-        
-        //Need to verify our object is allocated and not already marked
-        if(GC_SHOULD_PROCESS_AS_ROOT(meta)) {
-            GC_MARK_AS_ROOT(meta);
+        return nullptr;
+    }
 
-            tinfo.roots[tinfo.roots_count++] = obj;
-            if(GC_SHOULD_PROCESS_AS_YOUNG(meta)) {
-                tinfo.pending_roots.push_back(obj);
-            }
+    MetaData* meta = page->isLargeObjectPage() ? page->getMetaEntryAtIndex(0) : PageInfo::getObjectMetadataAligned(addr);
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Young slots on a page that is still waiting to be swept are dead objects from an earlier collection
+    if(page->pageset == PAGE_SET_NEEDS_SWEEP && GC_SHOULD_PROCESS_AS_YOUNG(meta)) {
+        return nullptr;
+    }
+#endif
+
+    return meta;
+}
+
+void checkPotentialPtr(void* addr, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    MetaData* meta = resolvePotentialPtr(addr);
+
+    //Need to verify our object is allocated and not already marked
+    if(meta != nullptr && GC_SHOULD_PROCESS_AS_ROOT(meta)) {
+        GC_MARK_AS_ROOT(meta);
+
+        void* obj = (void*)((uint8_t*)meta + sizeof(MetaData));
+        tinfo.roots[tinfo.roots_count++] = obj;
+        if(GC_SHOULD_PROCESS_AS_YOUNG(meta)) {
+            tinfo.pending_roots.push_back(obj);
         }
     }
 }
 
-void walkStack(BSQMemoryTheadLocalInfo& tinfo) noexcept 
+// Hand every possible pointer in the globals, the native stack and the registers to check
+template <typename F>
+void walkStack(BSQMemoryTheadLocalInfo& tinfo, F check) noexcept 
 {
     // Process global data (TODO -- later have flag to disable this after it is fixed as immortal)
     if(GlobalDataStorage::g_global_data.native_global_storage != nullptr) {
         void** curr = GlobalDataStorage::g_global_data.native_global_storage;
         while(curr < GlobalDataStorage::g_global_data.native_global_storage_end) {
-            checkPotentialPtr(*curr, tinfo);
+            check(*curr);
             curr++;
         }
     }
@@ -314,62 +562,207 @@ void walkStack(BSQMemoryTheadLocalInfo& tinfo) noexcept
     tinfo.loadNativeRootSet();
 
     for(size_t i = 0; i < tinfo.native_stack_count; i++) {
-        checkPotentialPtr(tinfo.native_stack_contents[i], tinfo);
-    }
-
-    checkPotentialPtr(tinfo.native_register_contents.rax, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.rbx, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.rcx, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.rdx, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.rsi, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.rdi, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r8, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r9, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r10, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r11, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r12, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r13, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r14, tinfo);
-    checkPotentialPtr(tinfo.native_register_contents.r15, tinfo);
+        check(tinfo.native_stack_contents[i]);
+    }
+
+    check(tinfo.native_register_contents.rax);
+    check(tinfo.native_register_contents.rbx);
+    check(tinfo.native_register_contents.rcx);
+    check(tinfo.native_register_contents.rdx);
+    check(tinfo.native_register_contents.rsi);
+    check(tinfo.native_register_contents.rdi);
+    check(tinfo.native_register_contents.r8);
+    check(tinfo.native_register_contents.r9);
+    check(tinfo.native_register_contents.r10);
+    check(tinfo.native_register_contents.r11);
+    check(tinfo.native_register_contents.r12);
+    check(tinfo.native_register_contents.r13);
+    check(tinfo.native_register_contents.r14);
+    check(tinfo.native_register_contents.r15);
 
     tinfo.unloadNativeRootSet();
 }
 
-void walkSingleRoot(void* root, BSQMemoryTheadLocalInfo& tinfo) noexcept
+// Mark a young object and record it for evacuation -- it only needs a visit stack entry if it has pointer slots to scan
+inline void markYoungObject(void* obj, MetaData* meta, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    GC_MARK_AS_MARKED(meta);
+    tinfo.pending_young.push_back(obj);
+
+    if(meta->type->layout_kind != PTR_LAYOUT_LEAF) {
+        tinfo.visit_stack.push_back(obj);
+    }
+}
+
+inline void visitChild(void* child, BSQMemoryTheadLocalInfo& tinfo) noexcept
 {
-    while(!tinfo.visit_stack.isEmpty()) {
-        MarkStackEntry entry = tinfo.visit_stack.pop_back();
-        TypeInfoBase* obj_type = GC_TYPE(entry.obj);
+    MetaData* meta = GC_GET_META_DATA_ADDR(child);
 
-        if((obj_type->ptr_mask == LEAF_PTR_MASK) | (entry.color == MARK_STACK_NODE_COLOR_BLACK)) {
-            // No children so do by definition
-            tinfo.pending_young.push_back(entry.obj);
+    // Check metadata isnt null for sanitys sake
+    if(meta != nullptr && GC_SHOULD_VISIT(meta)) {
+        markYoungObject(child, meta, tinfo);
+    }
+}
+
+// Scan up to budget objects from the visit stack -- every object is pushed once (marked when pushed) and the order does not matter for evacuation so the prefetch queue carries over between objects
+void scanVisitStack(BSQMemoryTheadLocalInfo& tinfo, size_t budget) noexcept
+{
+    PrefetchQueue<void*, BSQ_GC_PREFETCH_DISTANCE> children;
+    void* child = nullptr;
+
+    size_t scanned = 0;
+    while(true) {
+        if(tinfo.visit_stack.isEmpty() || scanned == budget) {
+            // Children still waiting in the prefetch queue may have more to scan (they are only pushed once the budget is used up)
+            if(!children.pop(child)) {
+                break;
+            }
+
+            visitChild(child, tinfo);
+            continue;
         }
-        else {
-            tinfo.visit_stack.push_back({entry.obj, MARK_STACK_NODE_COLOR_BLACK});
 
-            const char* ptr_mask = obj_type->ptr_mask;
-            void** slots = (void**)entry.obj;
+        void* obj = tinfo.visit_stack.pop_back();
+        scanned++;
 
-            while(*ptr_mask != '\0') {
-                char mask = *(ptr_mask++);
+        visitPointerSlots(GC_TYPE(obj), (void**)obj, [&](void** slot) {
+            void* sv = PTR_LAYOUT_LOAD_SLOT(slot);
+            __builtin_prefetch(GC_GET_META_DATA_ADDR(sv), 1);
+            if(children.push(sv, child)) {
+                visitChild(child, tinfo);
+            }
+        });
+    }
+}
+
+// Parallel marking -- make a child grey if it is young and this worker wins the atomic test-and-set on its mark
+inline void claimChild(void* child, MarkWorker* w) noexcept
+{
+    MetaData* meta = GC_GET_META_DATA_ADDR(child);
+
+    if(meta != nullptr && meta->isyoung && GC_TRY_MARK_ATOMIC(meta)) {
+        if(!w->deque.push(child)) {
+            w->overflow.push_back(child);
+        }
+    }
+}
+
+// Record a grey object for evacuation then queue its children to be claimed (the queue carries over between objects since the parallel order does not matter)
+void scanObjectParallel(void* obj, MarkWorker* w) noexcept
+{
+    w->pending_young.push_back(obj);
+
+    visitPointerSlots(GC_TYPE(obj), (void**)obj, [w](void** slot) {
+        __builtin_prefetch(GC_GET_META_DATA_ADDR(*slot), 1);
+
+        void* child = nullptr;
+        if(w->children.push(*slot, child)) {
+            claimChild(child, w);
+        }
+    });
+}
+
+// Out of local work -- steal from the other workers until one succeeds or every worker is idle (then nobody can make more grey objects)
+void* stealMarkWork(MarkWorker* w) noexcept
+{
+    BSQMemoryTheadLocalInfo* tinfo = w->tinfo;
+    tinfo->mark_active_workers.fetch_sub(1, std::memory_order_acq_rel);
+
+    while(true) {
+        for(size_t i = 1; i < tinfo->mark_worker_count; i++) {
+            MarkWorker* victim = &tinfo->mark_workers[(w->id + i) % tinfo->mark_worker_count];
+            if(victim->deque.isEmpty()) {
+                continue;
+            }
+
+            // Count as active before taking anything so the walk cannot be seen as done while we hold work
+            tinfo->mark_active_workers.fetch_add(1, std::memory_order_acq_rel);
+            void* obj = victim->deque.steal();
+            if(obj != nullptr) {
+                return obj;
+            }
+            tinfo->mark_active_workers.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        if(tinfo->mark_active_workers.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        thrd_yield();
+    }
+}
 
-                if(*slots != nullptr) {
-                    if ((mask == PTR_MASK_PTR) | PTR_MASK_STRING_AND_SLOT_PTR_VALUED(mask, *slots)) {
-                        MetaData* meta = GC_GET_META_DATA_ADDR(*slots);
+int markWorkerMain(void* arg) noexcept
+{
+    MarkWorker* w = (MarkWorker*)arg;
 
-                        // Check metadata isnt null for sanitys sake
-                        if(meta != nullptr && GC_SHOULD_VISIT(meta)) {
-                            GC_MARK_AS_MARKED(meta);
-                            tinfo.visit_stack.push_back({*slots, MARK_STACK_NODE_COLOR_GREY});
-                        }
-                    }
+    while(true) {
+        void* obj = nullptr;
+        if(!w->overflow.isEmpty()) {
+            obj = w->overflow.pop_back();
+        }
+        else {
+            obj = w->deque.pop();
+            if(obj == nullptr) {
+                // Children in the prefetch queue may still be unclaimed work
+                void* child = nullptr;
+                if(w->children.pop(child)) {
+                    claimChild(child, w);
+                    continue;
                 }
 
-                slots++;
+                obj = stealMarkWork(w);
+                if(obj == nullptr) {
+                    break;
+                }
+            }
+        }
+
+        scanObjectParallel(obj, w);
+    }
+
+    return 0;
+}
+
+// Mark from the pending roots with tinfo.mark_worker_count GC threads -- each worker gets its own pending_young list (processMarkedYoungObjects takes them in any order)
+void parallelMarkingWalk(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    size_t nworkers = tinfo.mark_worker_count;
+    for(size_t i = 0; i < nworkers; i++) {
+        MarkWorker* w = &tinfo.mark_workers[i];
+        w->deque.initialize();
+        w->overflow.initialize();
+        w->pending_young.initialize();
+    }
+
+    // Seed the workers round robin -- the pool threads stay parked until the phase is posted so the roots can be marked normally
+    size_t next = 0;
+    while(!tinfo.pending_roots.isEmpty()) {
+        void* obj = tinfo.pending_roots.pop_front();
+        MetaData* meta = GC_GET_META_DATA_ADDR(obj);
+        if(GC_SHOULD_VISIT(meta)) {
+            GC_MARK_AS_MARKED(meta);
+
+            MarkWorker* w = &tinfo.mark_workers[next];
+            if(!w->deque.push(obj)) {
+                w->overflow.push_back(obj);
             }
+            next = (next + 1) % nworkers;
         }
     }
+
+    tinfo.mark_active_workers.store(nworkers, std::memory_order_release);
+
+    tinfo.startGCWorkers(markWorkerMain, nworkers);
+    markWorkerMain(&tinfo.mark_workers[0]);
+    tinfo.waitGCWorkers();
+
+    for(size_t i = 0; i < nworkers; i++) {
+        MarkWorker* w = &tinfo.mark_workers[i];
+        GC_INVARIANT_CHECK(w->deque.isEmpty() && w->overflow.isEmpty());
+
+        w->deque.clear();
+        w->overflow.clear();
+    }
 }
 
 void markingWalk(BSQMemoryTheadLocalInfo& tinfo) noexcept
@@ -379,22 +772,29 @@ void markingWalk(BSQMemoryTheadLocalInfo& tinfo) noexcept
 #endif
     
     gtl_info.pending_roots.initialize();
-    gtl_info.visit_stack.initialize();
+    if(!tinfo.incremental_mark_active) {
+        gtl_info.visit_stack.initialize();
+    }
+
+    walkStack(tinfo, [&](void* addr) { checkPotentialPtr(addr, tinfo); });
 
-    walkStack(tinfo);
+    if(tinfo.mark_worker_count > 1) {
+        parallelMarkingWalk(tinfo);
+    }
 
     // Process the walk stack
     while(!tinfo.pending_roots.isEmpty()) {
         void* obj = tinfo.pending_roots.pop_front();
         MetaData* meta = GC_GET_META_DATA_ADDR(obj);
         if(GC_SHOULD_VISIT(meta)) {
-            GC_MARK_AS_MARKED(meta);
-
-            tinfo.visit_stack.push_back({obj, MARK_STACK_NODE_COLOR_GREY});
-            walkSingleRoot(obj, tinfo);
+            markYoungObject(obj, meta, tinfo);
+            scanVisitStack(tinfo, SIZE_MAX);
         }
     }
 
+    // Finish whatever an incremental cycle left grey (slices that did not get to it or targets shaded by the write barrier)
+    scanVisitStack(tinfo, SIZE_MAX);
+
     gtl_info.visit_stack.clear();
     gtl_info.pending_roots.clear();
 
@@ -410,6 +810,206 @@ void markingWalk(BSQMemoryTheadLocalInfo& tinfo) noexcept
 #endif
 }
 
+// Mark a young object found by the root scan that seeds an incremental cycle -- unlike checkPotentialPtr nothing is recorded as a root (the final pause finds the roots again)
+inline void seedPotentialPtr(void* addr, BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    MetaData* meta = resolvePotentialPtr(addr);
+    if(meta != nullptr && meta->isalloc && GC_SHOULD_VISIT(meta)) {
+        markYoungObject((void*)((uint8_t*)meta + sizeof(MetaData)), meta, tinfo);
+    }
+}
+
+// Job of the GC worker that marks a concurrent cycle -- marks everything reachable from the seeded snapshot while the mutator keeps running
+// (objects are never changed once the next allocation happens so only the stores GC_WRITE_BARRIER logs can add edges to what it scans)
+int concurrentMarkMain(void* arg) noexcept
+{
+    MarkWorker* w = (MarkWorker*)arg;
+    scanVisitStack(*w->tinfo, SIZE_MAX);
+
+    return 0;
+}
+
+void incrementalMarkStep() noexcept
+{
+    if(!gtl_info.incremental_mark_active) {
+        for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+            GCAllocator* alloc = gtl_info.g_gcallocs[i];
+            if(alloc != nullptr) {
+                alloc->flushBumpCursors();
+            }
+        }
+
+        gtl_info.pending_young.initialize();
+        gtl_info.visit_stack.initialize();
+        gtl_info.incremental_mark_active = true;
+
+        walkStack(gtl_info, [&](void* addr) { seedPotentialPtr(addr, gtl_info); });
+
+        if(gtl_info.enable_concurrent_marking) {
+            gtl_info.barrier_young.initialize();
+            gtl_info.concurrent_mark_running = true;
+
+            // One pool worker marks (the mutator is worker 0 and does not run the job)
+            gtl_info.startGCWorkers(concurrentMarkMain, 2);
+        }
+    }
+
+    if(!gtl_info.concurrent_mark_running) {
+        scanVisitStack(gtl_info, gtl_info.incremental_slice_objects);
+    }
+}
+
+// Final handshake with the background marker -- once it has drained the snapshot the barrier targets logged meanwhile are marked (markingWalk scans them)
+void finishConcurrentMark(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    tinfo.waitGCWorkers();
+    tinfo.concurrent_mark_running = false;
+
+    while(!tinfo.barrier_young.isEmpty()) {
+        visitChild(tinfo.barrier_young.pop_front(), tinfo);
+    }
+    tinfo.barrier_young.clear();
+}
+
+void abandonIncrementalMark(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    if(tinfo.concurrent_mark_running) {
+        finishConcurrentMark(tinfo);
+    }
+
+    if(tinfo.incremental_mark_active) {
+        // Every object the cycle marked is on pending_young (visit_stack only holds some of them again)
+        while(!tinfo.pending_young.isEmpty()) {
+            GC_CLEAR_MARK(GC_GET_META_DATA_ADDR(tinfo.pending_young.pop_front()));
+        }
+        tinfo.pending_young.clear();
+        tinfo.visit_stack.clear();
+
+        tinfo.incremental_mark_active = false;
+    }
+}
+
+void incrementalMarkShade(void* obj) noexcept
+{
+    // Inline string values are not pointers (see PTR_LAYOUT_SLOT_PTR_VALUED)
+    if(!PTR_LAYOUT_SLOT_PTR_VALUED(obj, true)) {
+        return;
+    }
+
+    // The marker owns the mark bits while it runs
+    if(gtl_info.concurrent_mark_running) {
+        gtl_info.barrier_young.push_back(obj);
+        return;
+    }
+
+    MetaData* meta = GC_GET_META_DATA_ADDR(obj);
+    if(GC_SHOULD_VISIT(meta)) {
+        markYoungObject(obj, meta, gtl_info);
+    }
+}
+
+// Young objects the seed scan marked may have lost every root by the final pause -- with no references from the other survivors they are garbage that is now old so the decrements free them
+void releaseFloatingYoung(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    while(!tinfo.pending_young.isEmpty()) {
+        void* obj = tinfo.pending_young.pop_front();
+        if(GC_REF_COUNT(obj) == 0 && !GC_IS_ROOT(obj)) {
+            tinfo.pending_decs.push_back(obj);
+        }
+    }
+}
+
+// Backup trace from the roots over the whole live heap redirecting every reference to an object moved by compaction
+void fixupCompactedReferences(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    tinfo.pending_roots.initialize();
+
+    // Roots are pinned so they are only starting points -- their marks are cleared with the other root marks at the end of collect
+    for(size_t i = 0; i < tinfo.roots_count; i++) {
+        GC_MARK_AS_MARKED(GC_GET_META_DATA_ADDR(tinfo.roots[i]));
+        tinfo.pending_roots.push_back(tinfo.roots[i]);
+    }
+
+    while(!tinfo.pending_roots.isEmpty()) {
+        void* obj = tinfo.pending_roots.pop_back();
+        TypeInfoBase* type_info = GC_TYPE(obj);
+
+        visitPointerSlots(type_info, (void**)obj, [&](void** slot) {
+            if(GC_IS_FORWARDED(*slot)) {
+                *slot = GC_FORWARD_PTR(*slot);
+            }
+
+            MetaData* meta = GC_GET_META_DATA_ADDR(*slot);
+            if(!GC_IS_MARKED(*slot)) {
+                GC_MARK_AS_MARKED(meta);
+                tinfo.pending_roots.push_back(*slot);
+            }
+        });
+    }
+
+    // Second walk to clear the marks we set on everything that is not a root
+    for(size_t i = 0; i < tinfo.roots_count; i++) {
+        tinfo.pending_roots.push_back(tinfo.roots[i]);
+    }
+
+    while(!tinfo.pending_roots.isEmpty()) {
+        void* obj = tinfo.pending_roots.pop_back();
+        TypeInfoBase* type_info = GC_TYPE(obj);
+
+        visitPointerSlots(type_info, (void**)obj, [&](void** slot) {
+            MetaData* meta = GC_GET_META_DATA_ADDR(*slot);
+            if(GC_IS_MARKED(*slot) && !GC_IS_ROOT(*slot)) {
+                GC_CLEAR_MARK(meta);
+                tinfo.pending_roots.push_back(*slot);
+            }
+        });
+    }
+
+    tinfo.pending_roots.clear();
+}
+
+//
+// Opportunistic old space compaction -- evacuate the sparsest pages of fragmented size classes then fix up references with a backup trace.
+// Must run while the roots are still marked (roots come from a conservative scan so they are pinned) and only when no decrements are pending 
+// (objects waiting on a decrement are unreachable so the trace would not fix their pointers).
+//
+void compactOldSpace(BSQMemoryTheadLocalInfo& tinfo) noexcept
+{
+    PageInfo* sources[BSQ_MAX_ALLOC_SLOTS] = {};
+    bool anysources = false;
+    size_t moved = 0;
+
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        GCAllocator* alloc = tinfo.g_gcallocs[i];
+        if(alloc == nullptr) {
+            continue;
+        }
+
+        sources[i] = alloc->selectCompactionPages();
+        for(PageInfo* p = sources[i]; p != nullptr; p = p->next) {
+            moved += alloc->evacuateCompactionPage(p);
+        }
+        anysources |= (sources[i] != nullptr);
+    }
+
+    if(!anysources) {
+        return;
+    }
+
+    if(moved != 0) {
+        fixupCompactedReferences(tinfo);
+    }
+
+    // Only now can the old slots (and their forward pointers) be reused
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(sources[i] != nullptr) {
+            tinfo.g_gcallocs[i]->finishCompaction(sources[i]);
+        }
+    }
+
+    MEM_STATS_OP(tinfo.total_compacted_objects += moved);
+}
+
 void collect() noexcept
 {   
 #ifdef MEM_STATS
@@ -417,18 +1017,36 @@ void collect() noexcept
 #endif
 
     static bool should_reset_pending_decs = true;
-    gtl_info.pending_young.initialize();
+
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        GCAllocator* alloc = gtl_info.g_gcallocs[i];
+        if(alloc != nullptr) {
+            alloc->flushBumpCursors();
+        }
+    }
+
+    if(gtl_info.concurrent_mark_running) {
+        finishConcurrentMark(gtl_info);
+    }
+
+    // An incremental (or concurrent) cycle already holds its marked objects in pending_young
+    if(!gtl_info.incremental_mark_active) {
+        gtl_info.pending_young.initialize();
+    }
     markingWalk(gtl_info);
     processMarkedYoungObjects(gtl_info);
-    gtl_info.pending_young.clear();
-
-    xmem_zerofill(gtl_info.forward_table, gtl_info.forward_table_index);
-    gtl_info.forward_table_index = 0;
 
     if(should_reset_pending_decs) {
         gtl_info.pending_decs.initialize();
         should_reset_pending_decs = false;
     }
+
+    if(gtl_info.incremental_mark_active) {
+        releaseFloatingYoung(gtl_info);
+        gtl_info.incremental_mark_active = false;
+    }
+    gtl_info.pending_young.clear();
+
     computeDeadRootsForDecrement(gtl_info);
     processDecrements(gtl_info);
     // We do not want to clear pending decs list every collection as it may still be populated
@@ -446,6 +1064,13 @@ void collect() noexcept
         }
     }
 
+    gtl_info.large_alloc.processCollectorSpans();
+    MEM_STATS_OP(gtl_info.total_live_bytes += gtl_info.large_alloc.getLiveBytes());
+
+    if(gtl_info.enable_old_compaction && gtl_info.pending_decs.isEmpty()) {
+        compactOldSpace(gtl_info);
+    }
+
     xmem_zerofill(gtl_info.old_roots, gtl_info.old_roots_count);
     gtl_info.old_roots_count = 0;
 
@@ -458,6 +1083,12 @@ void collect() noexcept
     xmem_zerofill(gtl_info.roots, gtl_info.roots_count);
     gtl_info.roots_count = 0;
     gtl_info.newly_filled_pages_count = 0;
+    gtl_info.newly_large_object_bytes = 0;
+
+    //Give cold empty pages back to the OS here unless the background thread is doing it
+    if(!GlobalPageGCManager::g_gc_page_manager.isBackgroundDecommitEnabled()) {
+        GlobalPageGCManager::g_gc_page_manager.decommitColdPages();
+    }
 
 #ifdef MEM_STATS
     auto end = std::chrono::high_resolution_clock::now();
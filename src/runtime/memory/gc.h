@@ -1,10 +1,24 @@
 #pragma once
 
-#ifdef GC_INVARIANTS
-#define GC_INVARIANT_CHECK(x) assert(x)
-#else
-#define GC_INVARIANT_CHECK(x)
-#endif
+#include "../common.h"
 
 //This methods drives the collection routine -- uses the thread local information from invoking thread to get pages 
 extern void collect() noexcept;
+
+//Run one bounded slice of incremental young marking (seeding a new cycle from the roots first if none is running) -- the allocators call this as pages fill once incremental marking is on
+//With concurrent marking the seeded cycle is handed to a GC pool worker instead and later steps do nothing
+extern void incrementalMarkStep() noexcept;
+
+//Mark the target of a pointer store made while an incremental cycle is running (see GC_WRITE_BARRIER)
+extern void incrementalMarkShade(void* obj) noexcept;
+
+//Drop a running incremental (or concurrent) cycle without collecting -- waits for the marker and clears every mark it set (thread teardown does this before stopping the GC workers)
+struct BSQMemoryTheadLocalInfo;
+extern void abandonIncrementalMark(BSQMemoryTheadLocalInfo& tinfo) noexcept;
+
+//
+//Insertion barrier for pointer stores into an object that a mark slice may have scanned already (anything allocated before the last allocation)
+//  -- initializing stores right after an allocation do not need it and neither do stores to the stack or globals (the final pause rescans those)
+//  -- the store is a relaxed atomic since a concurrent marker may be loading the slot (see PTR_LAYOUT_LOAD_SLOT) -- a plain store on x86
+//
+#define GC_WRITE_BARRIER(SLOT, V) { auto __bv = (V); __atomic_store_n((SLOT), __bv, __ATOMIC_RELAXED); if(gtl_info.incremental_mark_active) [[unlikely]] { incrementalMarkShade((void*)__bv); } }
@@ -1,10 +1,12 @@
 #include "threadinfo.h"
 
+#include <new>
+
 thread_local void* roots_array[BSQ_MAX_ROOTS];
 thread_local void* old_roots_array[BSQ_MAX_ROOTS];
-thread_local void* forward_table_array[BSQ_MAX_FWD_TABLE_ENTRIES];
 
 thread_local GCAllocator* g_gcallocs_array[BSQ_MAX_ALLOC_SLOTS];
+alignas(GCAllocator) thread_local uint8_t g_gcallocs_storage[BSQ_SIZE_CLASS_COUNT][sizeof(GCAllocator)];
 
 thread_local BSQMemoryTheadLocalInfo gtl_info;
 
@@ -30,12 +32,145 @@ void BSQMemoryTheadLocalInfo::initialize(size_t tl_id, void** caller_rbp) noexce
     this->old_roots_count = 0;
     xmem_zerofill(this->old_roots, BSQ_MAX_ROOTS);
 
-    this->forward_table = forward_table_array;
-    this->forward_table_index = 0;
-    xmem_zerofill(this->forward_table, BSQ_MAX_ROOTS);
-
     this->g_gcallocs = g_gcallocs_array;
     xmem_zerofill(this->g_gcallocs, BSQ_MAX_ALLOC_SLOTS);
+
+    assert(mtx_init(&this->evac_lock, mtx_plain) == thrd_success);
+
+    for(size_t i = 0; i < BSQ_MAX_MARK_WORKERS; i++) {
+        this->mark_workers[i].tinfo = this;
+        this->mark_workers[i].id = i;
+    }
+
+    assert(mtx_init(&this->gc_workers.lock, mtx_plain) == thrd_success);
+    assert(cnd_init(&this->gc_workers.wake) == thrd_success);
+    assert(cnd_init(&this->gc_workers.done) == thrd_success);
+}
+
+void BSQMemoryTheadLocalInfo::release() noexcept
+{
+    //A concurrent marker still owns the pool (and the mark bits) until its cycle is finished
+    abandonIncrementalMark(*this);
+
+    this->stopGCWorkers();
+    GlobalPageGCManager::g_gc_page_manager.flushPageCache(*this);
+
+    if(this->evac_objects != nullptr) {
+        assert(munmap(this->evac_objects, this->evac_objects_capacity * sizeof(void*)) == 0);
+        this->evac_objects = nullptr;
+        this->evac_objects_count = 0;
+        this->evac_objects_capacity = 0;
+    }
+}
+
+static int gcWorkerThreadMain(void* arg) noexcept
+{
+    MarkWorker* w = (MarkWorker*)arg;
+    GCWorkerPool& pool = w->tinfo->gc_workers;
+
+    assert(mtx_lock(&pool.lock) == thrd_success);
+    while(true) {
+        while(pool.phase == w->phase_seen && !pool.stopping) {
+            assert(cnd_wait(&pool.wake, &pool.lock) == thrd_success);
+        }
+
+        if(pool.stopping) {
+            break;
+        }
+
+        w->phase_seen = pool.phase;
+        if(w->id >= pool.job_workers) {
+            continue;
+        }
+
+        thrd_start_t job = pool.job;
+        assert(mtx_unlock(&pool.lock) == thrd_success);
+        job(w);
+        assert(mtx_lock(&pool.lock) == thrd_success);
+
+        if(--pool.running == 0) {
+            assert(cnd_signal(&pool.done) == thrd_success);
+        }
+    }
+    assert(mtx_unlock(&pool.lock) == thrd_success);
+
+    return 0;
+}
+
+void BSQMemoryTheadLocalInfo::startGCWorkers(thrd_start_t job, size_t nworkers) noexcept
+{
+    GCWorkerPool& pool = this->gc_workers;
+    assert(2 <= nworkers && nworkers <= BSQ_MAX_MARK_WORKERS);
+
+    assert(mtx_lock(&pool.lock) == thrd_success);
+    GC_INVARIANT_CHECK(pool.running == 0);
+
+    while(pool.threads + 1 < nworkers) {
+        MarkWorker* w = &this->mark_workers[++pool.threads];
+        w->phase_seen = pool.phase;
+        assert(thrd_create(&w->thread, gcWorkerThreadMain, w) == thrd_success);
+    }
+
+    pool.job = job;
+    pool.job_workers = nworkers;
+    pool.running = nworkers - 1;
+    pool.phase++;
+    assert(cnd_broadcast(&pool.wake) == thrd_success);
+    assert(mtx_unlock(&pool.lock) == thrd_success);
+}
+
+void BSQMemoryTheadLocalInfo::waitGCWorkers() noexcept
+{
+    GCWorkerPool& pool = this->gc_workers;
+
+    assert(mtx_lock(&pool.lock) == thrd_success);
+    while(pool.running != 0) {
+        assert(cnd_wait(&pool.done, &pool.lock) == thrd_success);
+    }
+    assert(mtx_unlock(&pool.lock) == thrd_success);
+}
+
+void BSQMemoryTheadLocalInfo::stopGCWorkers() noexcept
+{
+    GCWorkerPool& pool = this->gc_workers;
+
+    assert(mtx_lock(&pool.lock) == thrd_success);
+    GC_INVARIANT_CHECK(pool.running == 0);
+    pool.stopping = true;
+    assert(cnd_broadcast(&pool.wake) == thrd_success);
+    assert(mtx_unlock(&pool.lock) == thrd_success);
+
+    for(size_t i = 1; i <= pool.threads; i++) {
+        assert(thrd_join(this->mark_workers[i].thread, NULL) == thrd_success);
+    }
+
+    pool.threads = 0;
+    pool.stopping = false;
+}
+
+GCAllocator* BSQMemoryTheadLocalInfo::createAllocatorForSizeClass(size_t cidx) noexcept
+{
+    assert(cidx < BSQ_SIZE_CLASS_COUNT && this->g_gcallocs[cidx] == nullptr);
+
+    uint16_t allocsize = (uint16_t)getSizeClassBytes(cidx);
+    GCAllocator* gcalloc = new (g_gcallocs_storage[cidx]) GCAllocator(allocsize, REAL_ENTRY_SIZE(allocsize), collect);
+    gcalloc->setOwner(this);
+    gcalloc->setPageSelectionPolicy(this->page_alloc_policy, this->page_evac_policy);
+
+    this->g_gcallocs[cidx] = gcalloc;
+    return gcalloc;
+}
+
+void BSQMemoryTheadLocalInfo::setPageSelectionPolicy(uint8_t allocpolicy, uint8_t evacpolicy) noexcept
+{
+    this->page_alloc_policy = allocpolicy;
+    this->page_evac_policy = evacpolicy;
+
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(this->g_gcallocs[i] != nullptr) {
+            this->g_gcallocs[i]->setPageSelectionPolicy(allocpolicy, evacpolicy);
+        }
+    }
 }
 
 void BSQMemoryTheadLocalInfo::loadNativeRootSet() noexcept
@@ -1,6 +1,8 @@
 #pragma once 
 
 #include "allocator.h"
+#include "../support/workstealdeque.h"
+#include "../support/prefetchqueue.h"
 
 //Seems that chrono is pretty fast and shouldn't mess with our metrics too much here
 #ifdef MEM_STATS
@@ -9,14 +11,44 @@
 #endif
 
 #define InitBSQMemoryTheadLocalInfo() { ALLOC_LOCK_ACQUIRE(); register void** rbp asm("rbp"); gtl_info.initialize(GlobalThreadAllocInfo::s_thread_counter++, rbp); ALLOC_LOCK_RELEASE(); }
+#define ReleaseBSQMemoryTheadLocalInfo() { gtl_info.release(); }
 
-#define MARK_STACK_NODE_COLOR_GREY 0
-#define MARK_STACK_NODE_COLOR_BLACK 1
+struct BSQMemoryTheadLocalInfo;
 
-struct MarkStackEntry
+//One GC thread of a parallel marking walk and of the parallel evacuation after it (worker 0 is the collecting thread itself)
+struct MarkWorker
 {
-    void* obj;
-    uintptr_t color;
+    BSQMemoryTheadLocalInfo* tinfo;
+    size_t id;
+
+    WorkStealingDeque<void> deque; //grey objects that other workers may steal
+    ArrayList<void*> overflow; //grey objects that did not fit in the deque (private to this worker)
+    ArrayList<void*> pending_young; //objects this worker marked -- in no particular order
+    PrefetchQueue<void*, BSQ_GC_PREFETCH_DISTANCE> children; //children found but not claimed yet (empty between walks)
+
+    EvacBuffer evac_buffers[BSQ_SIZE_CLASS_COUNT]; //private evacuation page per size class
+    ArrayList<void*> evacuated; //new addresses of the objects this worker copied (it fixes their pointers too)
+    ArrayList<void*> pinned; //roots and large objects this worker claimed (promoted in place by the collecting thread)
+
+    thrd_t thread; //the pool thread that runs this worker (unused for worker 0)
+    uint64_t phase_seen; //last phase of the pool this thread woke up for
+};
+
+//Persistent GC threads for the parallel phases of one thread's collector -- thread i runs mark_workers[i] (worker 0 is the collecting thread)
+//  -- threads are started the first time a phase needs them and are parked on wake between phases, ReleaseBSQMemoryTheadLocalInfo stops them
+//  -- the allocators they evacuate into belong to the collecting thread so they never use (or need to hand back) pages of their own
+struct GCWorkerPool
+{
+    mtx_t lock;
+    cnd_t wake; //a phase was posted or the pool is stopping
+    cnd_t done; //the last worker of a phase finished
+
+    size_t threads; //pool threads started so far
+    uint64_t phase; //bumped every time a phase is posted
+    thrd_start_t job; //what the workers of the current phase run (on their MarkWorker)
+    size_t job_workers; //workers 1 .. job_workers - 1 run the job
+    size_t running; //workers of the current phase that are not done yet
+    bool stopping;
 };
 
 struct RegisterContents
@@ -47,6 +79,8 @@ struct BSQMemoryTheadLocalInfo
     size_t tl_id; //ID of the thread
 
     GCAllocator** g_gcallocs;
+    GCLargeObjectAllocator large_alloc; //objects bigger than BSQ_SIZE_CLASS_MAX_BYTES
+    GCPageCache page_cache; //empty pages owned by this thread (see GlobalPageGCManager)
 
     ////
     //Mark Phase information
@@ -63,15 +97,13 @@ struct BSQMemoryTheadLocalInfo
     size_t old_roots_count;
     void** old_roots;
 
-    size_t forward_table_index = 0;
-    void** forward_table;
-
     uint32_t newly_filled_pages_count = 0;
+    size_t newly_large_object_bytes = 0; //mapped bytes of the large object spans allocated since the last collection
 
     ArrayList<void*> pending_roots; //the worklist of roots that we need to do visits from
-    ArrayList<MarkStackEntry> visit_stack; //stack for doing a depth first visit (and topo organization) of the object graph
+    ArrayList<void*> visit_stack; //marked objects whose slots still have to be scanned (depth first)
 
-    ArrayList<void*> pending_young; //the list of young objects that need to be processed
+    ArrayList<void*> pending_young; //the list of young objects that need to be processed (in mark order)
     ArrayList<void*> pending_decs; //the list of objects that need to be decremented 
 
     //TODO: Once PID is implemented this will need to use this->max_decrement_count
@@ -83,11 +115,47 @@ struct BSQMemoryTheadLocalInfo
     //We may want this in prod, so i'll have it always be visible
     bool disable_automatic_collections = false;
 
+    //Opportunistically compact fragmented size classes at the end of a collection (see compactOldSpace)
+    bool enable_old_compaction = false;
+
+    //Number of GC threads used for marking and evacuation (1 is the serial walk) -- set with setMarkWorkerCount
+    size_t mark_worker_count = 1;
+    std::atomic<size_t> mark_active_workers; //workers that may still produce grey objects (the walk is done when this hits 0)
+    MarkWorker mark_workers[BSQ_MAX_MARK_WORKERS];
+    GCWorkerPool gc_workers;
+
+    //Parallel evacuation (with the mark workers) -- the marked lists are flattened into evac_objects and workers claim chunks of it by bumping evac_cursor
+    //  -- the lock only guards the size class allocators (evacuation buffer refills)
+    mtx_t evac_lock;
+    void** evac_objects; //every marked object of the collection (kept between collections and only grown)
+    size_t evac_objects_count;
+    size_t evac_objects_capacity;
+    std::atomic<size_t> evac_cursor; //first unclaimed entry of evac_objects
+    std::atomic<size_t> evac_copying_workers; //workers still copying (pointers are fixed once this hits 0)
+
+    //Incremental young marking (see incrementalMarkStep) -- set with setIncrementalMarking
+    //  -- while it is on pointer stores into an object that may have been scanned already (any allocation since it was made) must use GC_WRITE_BARRIER
+    bool enable_incremental_marking = false;
+    size_t incremental_slice_objects = BSQ_INCREMENTAL_MARK_SLICE_OBJECTS; //most objects scanned by one slice
+    bool incremental_mark_active = false; //a cycle was started (visit_stack and pending_young hold its state) and collect has not finished it yet
+
+    //Concurrent young marking -- set with setConcurrentMarking, a cycle is seeded as above but then marked by a GC pool worker while the mutator runs
+    //  -- the marker owns visit_stack, pending_young and all mark bits until collect joins it so GC_WRITE_BARRIER only logs its targets in barrier_young
+    bool enable_concurrent_marking = false;
+    bool concurrent_mark_running = false;
+    ArrayList<void*> barrier_young; //barrier targets stored while the marker runs (marked in the final pause)
+
+    //Page selection policies (PAGE_SELECT_X) for allocators of this thread -- set with setPageSelectionPolicy
+    uint8_t page_alloc_policy = PAGE_SELECT_LOWEST_UTIL;
+    uint8_t page_evac_policy = PAGE_SELECT_LOWEST_UTIL;
+
 #ifdef MEM_STATS
     uint64_t num_allocs = 0;
-    uint64_t total_gc_pages = 0;
+    uint64_t total_gc_pages = 0; //size class pages only (large object spans are in total_large_object_bytes)
+    uint64_t total_large_object_bytes = 0; //mapped bytes of the live large object spans
     uint64_t total_empty_gc_pages = 0;
     uint64_t total_live_bytes = 0; //doesnt include canary or metadata size
+    uint64_t total_compacted_objects = 0; //old objects moved by compaction
 
     int collection_times_index = 0;
     double collection_times[MAX_MEMSTAT_TIMES_INDEX]; //store in ms how much time each collection takes
@@ -106,21 +174,95 @@ struct BSQMemoryTheadLocalInfo
     bool disable_stack_refs_for_tests = false;
 #endif
 
-    BSQMemoryTheadLocalInfo() noexcept : tl_id(0), g_gcallocs(nullptr), native_stack_base(nullptr), native_stack_count(0), native_stack_contents(nullptr), roots_count(0), roots(nullptr), old_roots_count(0), old_roots(nullptr), forward_table_index(0), forward_table(nullptr), pending_roots(), visit_stack(), pending_young(), pending_decs(), max_decrement_count(BSQ_INITIAL_MAX_DECREMENT_COUNT) { }
+    BSQMemoryTheadLocalInfo() noexcept : tl_id(0), g_gcallocs(nullptr), large_alloc(), page_cache(), native_stack_base(nullptr), native_stack_count(0), native_stack_contents(nullptr), roots_count(0), roots(nullptr), old_roots_count(0), old_roots(nullptr), pending_roots(), visit_stack(), pending_young(), pending_decs(), max_decrement_count(BSQ_INITIAL_MAX_DECREMENT_COUNT), mark_active_workers(0), mark_workers(), gc_workers(), evac_lock(), evac_objects(nullptr), evac_objects_count(0), evac_objects_capacity(0), evac_cursor(0), evac_copying_workers(0), barrier_young() { }
 
     inline GCAllocator* getAllocatorForPageSize(PageInfo* page) noexcept {
-        GCAllocator* gcalloc = this->g_gcallocs[page->allocsize >> 3];
+        GCAllocator* gcalloc = this->g_gcallocs[getSizeClassIndex(page->allocsize)];
+        return gcalloc;
+    }
+
+    //Create and register the allocator for a size class the first time we see an object of that class
+    GCAllocator* createAllocatorForSizeClass(size_t cidx) noexcept;
+
+    void setMarkWorkerCount(size_t count) noexcept
+    {
+        assert(1 <= count && count <= BSQ_MAX_MARK_WORKERS);
+        this->mark_worker_count = count;
+    }
+
+    //Run job on workers 1 .. nworkers - 1 of the pool (starting threads as needed) -- the caller runs worker 0 itself if it takes part
+    void startGCWorkers(thrd_start_t job, size_t nworkers) noexcept;
+
+    //Wait until every worker of the phase posted by startGCWorkers is done (and parked again)
+    void waitGCWorkers() noexcept;
+
+    //Stop and join the pool threads (they are started again by the next phase)
+    void stopGCWorkers() noexcept;
+
+    //A cycle that is already running is still finished by the next collection when this turns incremental marking off
+    void setIncrementalMarking(bool enable, size_t slice_objects) noexcept
+    {
+        assert(slice_objects != 0);
+        this->enable_incremental_marking = enable;
+        this->incremental_slice_objects = slice_objects;
+    }
+
+    //As with setIncrementalMarking a running cycle is still finished by the next collection
+    void setConcurrentMarking(bool enable) noexcept
+    {
+        this->enable_concurrent_marking = enable;
+    }
+
+    //Fresh allocation since the last collection -- filled pages count as whole blocks and large object spans as the bytes they map (so the threshold is the same for every block size)
+    inline size_t getNewlyAllocatedBytes() const noexcept
+    {
+        return ((size_t)this->newly_filled_pages_count * BSQ_BLOCK_ALLOCATION_SIZE) + this->newly_large_object_bytes;
+    }
+
+    //True if mark cycles are started ahead of the collection threshold (see incrementalMarkStep)
+    inline bool isMarkAheadEnabled() const noexcept
+    {
+        return this->enable_incremental_marking || this->enable_concurrent_marking;
+    }
+
+    //Set the page selection policies for all current and future allocators of this thread
+    void setPageSelectionPolicy(uint8_t allocpolicy, uint8_t evacpolicy) noexcept;
+
+    inline GCAllocator* getAllocatorForSizeClass(size_t cidx) noexcept {
+        GCAllocator* gcalloc = this->g_gcallocs[cidx];
+        if(gcalloc == nullptr) [[unlikely]] {
+            gcalloc = this->createAllocatorForSizeClass(cidx);
+        }
         return gcalloc;
     }
 
+    //Generic allocation entry point -- picks the size class allocator for the type (or the large object space)
+    inline void* allocate(TypeInfoBase* type) noexcept {
+        if(type->type_size > BSQ_SIZE_CLASS_MAX_BYTES) [[unlikely]] {
+            return this->large_alloc.allocate(type);
+        }
+
+        return this->getAllocatorForSizeClass(getSizeClassIndex(type->type_size))->allocate(type);
+    }
+
     void initialize(size_t tl_id, void** caller_rbp) noexcept;
 
+    //Thread teardown -- stops the GC worker threads and the pages cached by this thread go back to the global pool where other threads (and the decommitter) see them
+    void release() noexcept;
+
+    //Register hand built allocators -- each one must be exactly one of the size classes
     template <size_t NUM>
     void initializeGC(GCAllocator* allocs[NUM]) noexcept
     {
         for(size_t i = 0; i < NUM; i++) {
             GCAllocator* alloc = allocs[i];
-            this->g_gcallocs[alloc->getAllocSize() >> 3] = alloc;
+            assert(isSizeClassBytes(alloc->getAllocSize()));
+
+            size_t cidx = getSizeClassIndex(alloc->getAllocSize());
+            assert(this->g_gcallocs[cidx] == nullptr || this->g_gcallocs[cidx] == alloc);
+            alloc->setOwner(this);
+            alloc->setPageSelectionPolicy(this->page_alloc_policy, this->page_evac_policy);
+            this->g_gcallocs[cidx] = alloc;
         }
     }
 
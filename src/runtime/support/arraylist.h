@@ -18,6 +18,9 @@ struct ArrayListSegment {
 template <typename T>
 class ArrayList {
 private:
+    //Whole entries that fit in a segment page after the header -- the end of the page is not entry aligned when sizeof(T) does not divide it
+    constexpr static size_t SEGMENT_ENTRIES = (BSQ_XALLOC_PAGE_SIZE - sizeof(ArrayListSegment<T>)) / sizeof(T);
+
     T* head; //either head == tail (and empty) OR head is first valid element in list
     T* tail; //tail is always FIRST invalid element off end of list
 
@@ -42,7 +45,7 @@ private:
         this->tail_segment->next = xseg;
         this->tail_segment = xseg;
         this->tail_min = xseg->data;
-        this->tail_max = (T*)((uint8_t*)xseg + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->tail_max = xseg->data + SEGMENT_ENTRIES;
         this->tail = xseg->data;
 
         *(this->tail++) = v;
@@ -52,12 +55,21 @@ private:
     {
         DSA_INVARIANT_CHECK(this->head == this->head_max);
 
+        //Popped the last entry of a full single segment list -- just reuse the segment from the start
+        if(this->head_segment == this->tail_segment) {
+            DSA_INVARIANT_CHECK(this->head == this->tail);
+
+            this->head = this->head_min;
+            this->tail = this->tail_min;
+            return;
+        }
+
         ArrayListSegment<T>* xseg = this->head_segment;
         this->head_segment = this->head_segment->next;
         this->head_segment->prev = nullptr;
 
         this->head_min = this->head_segment->data;
-        this->head_max = (T*)((uint8_t*)this->head_segment + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->head_max = this->head_segment->data + SEGMENT_ENTRIES;
         this->head = this->head_min;
 
         XAllocPageManager::g_page_manager.freePage(xseg);
@@ -72,7 +84,7 @@ private:
         this->tail_segment->next = nullptr;
 
         this->tail_min = this->tail_segment->data;
-        this->tail_max = (T*)((uint8_t*)this->tail_segment + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->tail_max = this->tail_segment->data + SEGMENT_ENTRIES;
         this->tail = this->tail_max;
 
         XAllocPageManager::g_page_manager.freePage(xseg);
@@ -130,12 +142,12 @@ public:
         //Empty case and we need to set head too
         this->head_segment = xseg;
         this->head_min = xseg->data;
-        this->head_max = (T*)((uint8_t*)xseg + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->head_max = xseg->data + SEGMENT_ENTRIES;
         this->head = xseg->data;
 
         this->tail_segment = xseg;
         this->tail_min = xseg->data;
-        this->tail_max = (T*)((uint8_t*)xseg + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->tail_max = xseg->data + SEGMENT_ENTRIES;
         this->tail = xseg->data;
 
         DSA_INVARIANT_CHECK(this->invariant());
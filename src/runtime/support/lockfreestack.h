@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../common.h"
+
+#include <atomic>
+
+//
+//A non-blocking (Treiber) stack of GC block aligned nodes that are linked through their next field
+//  -- The head is a tagged pointer and every successful update bumps the tag, so a CAS with a stale head fails even if the same node is back on top (ABA)
+//  -- The tag lives in the bits that are always zero in a block aligned user space pointer (the low block offset bits and the top 16 bits)
+//  -- Nodes are never unmapped while the stack is in use, so reading next from a node another thread just popped is harmless (the CAS then fails)
+//  -- Throughput is about that of a mutex protected list (both walk the batch) -- the point is that a thread descheduled mid operation never stalls the others
+//
+template <typename T>
+class TaggedLockFreeStack
+{
+private:
+    std::atomic<uint64_t> head;
+
+    constexpr static uint64_t ADDR_MASK = 0x0000FFFFFFFFFFFFul & PAGE_ADDR_MASK;
+    constexpr static uint64_t TAG_LOW_MASK = BSQ_BLOCK_ALLOCATION_SIZE - 1ul;
+    constexpr static uint64_t TAG_HIGH_SHIFT = 48;
+
+    static inline T* unpackNode(uint64_t tp) noexcept
+    {
+        return (T*)(tp & ADDR_MASK);
+    }
+
+    static inline uint64_t unpackTag(uint64_t tp) noexcept
+    {
+        return (tp & TAG_LOW_MASK) | ((tp >> TAG_HIGH_SHIFT) << BSQ_BLOCK_ALLOCATION_SIZE_LOG2);
+    }
+
+    //Tag bits past the available space are shifted out so the tag just wraps
+    static inline uint64_t pack(T* node, uint64_t tag) noexcept
+    {
+        return (uint64_t)node | (tag & TAG_LOW_MASK) | ((tag >> BSQ_BLOCK_ALLOCATION_SIZE_LOG2) << TAG_HIGH_SHIFT);
+    }
+
+    static inline uint64_t nextHead(uint64_t old, T* node) noexcept
+    {
+        return pack(node, unpackTag(old) + 1);
+    }
+
+    //Stale poppers may read next while the owner writes it so all accesses here are (relaxed) atomic
+    static inline T* loadNext(T* node) noexcept
+    {
+        return __atomic_load_n(&node->next, __ATOMIC_RELAXED);
+    }
+
+    static inline void storeNext(T* node, T* next) noexcept
+    {
+        __atomic_store_n(&node->next, next, __ATOMIC_RELAXED);
+    }
+
+public:
+    TaggedLockFreeStack() noexcept : head(0) { }
+
+    inline bool isEmpty() const noexcept
+    {
+        return unpackNode(this->head.load(std::memory_order_acquire)) == nullptr;
+    }
+
+    //Push the chain first ... last (already linked through next)
+    void pushBatch(T* first, T* last) noexcept
+    {
+        assert(((uintptr_t)first & ~ADDR_MASK) == 0 && ((uintptr_t)last & ~ADDR_MASK) == 0);
+
+        uint64_t old = this->head.load(std::memory_order_relaxed);
+        do {
+            storeNext(last, unpackNode(old));
+        } while(!this->head.compare_exchange_weak(old, nextHead(old, first), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    inline void push(T* node) noexcept
+    {
+        this->pushBatch(node, node);
+    }
+
+    //Pop up to count nodes as a nullptr terminated chain, the number of nodes taken is stored in popped
+    T* popBatch(size_t count, size_t& popped) noexcept
+    {
+        uint64_t old = this->head.load(std::memory_order_acquire);
+        while(true) {
+            T* first = unpackNode(old);
+            if(first == nullptr) {
+                popped = 0;
+                return nullptr;
+            }
+
+            //If the head is unchanged when we CAS then nothing was pushed or popped so the chain we walked is still intact
+            T* last = first;
+            size_t n = 1;
+            for(T* nn = loadNext(last); n < count && nn != nullptr; nn = loadNext(last)) {
+                last = nn;
+                n++;
+            }
+
+            if(this->head.compare_exchange_weak(old, nextHead(old, loadNext(last)), std::memory_order_acquire, std::memory_order_acquire)) {
+                storeNext(last, nullptr);
+                popped = n;
+                return first;
+            }
+        }
+    }
+
+    inline T* pop() noexcept
+    {
+        size_t popped = 0;
+        return this->popBatch(1, popped);
+    }
+
+    //Take the entire stack in one step
+    T* popAll() noexcept
+    {
+        uint64_t old = this->head.load(std::memory_order_acquire);
+        while(!this->head.compare_exchange_weak(old, nextHead(old, nullptr), std::memory_order_acquire, std::memory_order_acquire)) {
+            ;
+        }
+
+        return unpackNode(old);
+    }
+};
@@ -10,34 +10,39 @@ private:
 
     //
     //Original implementation designed for 12 bits per level fails
-    //due to the fact that our pages being 4096 bytes, meaning since
+    //due to the fact that our (support) pages being 4096 bytes, meaning since
     //each block stores a void* we can have up to 4096/8 = 512 entries
     //so in order to utilize space most effectively we can have
     //log2(512) = 9 bits per level
     //
+    //The lowest level is indexed by the bits just above the GC block offset, so
+    //bigger blocks shift every level up (and the top level just sees zeros above bit 47)
+    //
     
     constexpr static uintptr_t PAGETABLE_LEVELS = 4;
     constexpr static uintptr_t BITS_PER_LEVEL = 9; 
     
-    constexpr static uintptr_t LEVEL1_SHIFT = 39; 
-    constexpr static uintptr_t LEVEL2_SHIFT = 30; 
-    constexpr static uintptr_t LEVEL3_SHIFT = 21; 
-    constexpr static uintptr_t LEVEL4_SHIFT = 12; 
-    constexpr static uintptr_t LEVEL_MASK = 0x1FF; 
-    constexpr static uintptr_t PAGE_MASK = 0xFFF;
-    constexpr static uintptr_t PAGE_PRESENT = 1;
+    constexpr static uintptr_t LEVEL4_SHIFT = BSQ_BLOCK_ALLOCATION_SIZE_LOG2; 
+    constexpr static uintptr_t LEVEL3_SHIFT = LEVEL4_SHIFT + BITS_PER_LEVEL; 
+    constexpr static uintptr_t LEVEL2_SHIFT = LEVEL3_SHIFT + BITS_PER_LEVEL; 
+    constexpr static uintptr_t LEVEL1_SHIFT = LEVEL2_SHIFT + BITS_PER_LEVEL; 
+    constexpr static uintptr_t LEVEL_MASK = (1ul << BITS_PER_LEVEL) - 1; 
+
+    static_assert((BSQ_XALLOC_PAGE_SIZE / sizeof(void*)) == (1ul << BITS_PER_LEVEL), "Page table levels must fill a support page");
+    static_assert(LEVEL1_SHIFT + BITS_PER_LEVEL >= 48, "Page table does not cover the 48 bit address space");
 
 public:
     PageTableInUseInfo() noexcept : pagetable_root(nullptr) {}
 
-    void pagetable_insert(void* addr) noexcept {
+    //Each entry stores the owning page for the block -- the block itself for regular pages or the head of a multi-block span
+    void pagetable_insert(void* addr, void* owner) noexcept {
         if(this->pagetable_root == nullptr) {
             this->pagetable_root = (void**)XAllocPageManager::g_page_manager.allocatePage();
             xmem_zerofillpage(this->pagetable_root);
         }
 
         uintptr_t address = (uintptr_t)addr;
-        uintptr_t index1 = (address >> LEVEL1_SHIFT) & LEVEL_MASK; // Bits 47-39
+        uintptr_t index1 = (address >> LEVEL1_SHIFT) & LEVEL_MASK; // Bits 47-39 (for 4KB blocks)
         uintptr_t index2 = (address >> LEVEL2_SHIFT) & LEVEL_MASK; // Bits 38-30
         uintptr_t index3 = (address >> LEVEL3_SHIFT) & LEVEL_MASK; // Bits 29-21
         uintptr_t index4 = (address >> LEVEL4_SHIFT) & LEVEL_MASK; // Bits 20-12
@@ -61,37 +66,60 @@ public:
         }
 
         void** level4 = (void**)level3[index3];
-        level4[index4] = (void*)PAGE_PRESENT;  
+        level4[index4] = owner;  
+    }
+
+    void pagetable_insert(void* addr) noexcept {
+        this->pagetable_insert(addr, (void*)((uintptr_t)addr & PAGE_ADDR_MASK));
+    }
+
+    //Interior levels are kept around since they are likely to be needed again
+    void pagetable_remove(void* addr) noexcept {
+        uintptr_t address = (uintptr_t)addr;
+        uintptr_t index1 = (address >> LEVEL1_SHIFT) & LEVEL_MASK;
+        uintptr_t index2 = (address >> LEVEL2_SHIFT) & LEVEL_MASK;
+        uintptr_t index3 = (address >> LEVEL3_SHIFT) & LEVEL_MASK;
+        uintptr_t index4 = (address >> LEVEL4_SHIFT) & LEVEL_MASK;
+
+        void** level2 = (void**)this->pagetable_root[index1];
+        void** level3 = (void**)level2[index2];
+        void** level4 = (void**)level3[index3];
+        level4[index4] = nullptr;
     }
 
     bool pagetable_query(void* addr) const noexcept {
+        return this->pagetable_lookup(addr) != nullptr;
+    }
+
+    //Returns the owning page for an address (or nullptr if it is not in a GC page)
+    void* pagetable_lookup(void* addr) const noexcept {
         if(this->pagetable_root == nullptr) {
-            return false;
+            return nullptr;
         }
         
         uintptr_t address = (uintptr_t)addr;
-        uintptr_t index1 = (address >> LEVEL1_SHIFT) & LEVEL_MASK; // Bits 47-39
+        uintptr_t index1 = (address >> LEVEL1_SHIFT) & LEVEL_MASK; // Bits 47-39 (for 4KB blocks)
         uintptr_t index2 = (address >> LEVEL2_SHIFT) & LEVEL_MASK; // Bits 38-30
         uintptr_t index3 = (address >> LEVEL3_SHIFT) & LEVEL_MASK; // Bits 29-21
         uintptr_t index4 = (address >> LEVEL4_SHIFT) & LEVEL_MASK; // Bits 20-12
 
         void** level1 = pagetable_root;
         if(!level1[index1]) {
-            return false;
+            return nullptr;
         }
 
         void** level2 = (void**)level1[index1];
         if(!level2[index2]) {
-            return false;
+            return nullptr;
         }
 
         void** level3 = (void**)level2[index2];
         if(!level3[index3]) {
-            return false;
+            return nullptr;
         }
 
         void** level4 = (void**)level3[index3];
-        return level4[index4] == (void*)PAGE_PRESENT;
+        return level4[index4];
     }
 };
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../common.h"
+
+//
+//A small FIFO that delays work on an address for a few steps after it was found so a prefetch issued at push time has time to land
+//  -- push hands back the entry that falls out of the full queue (so the caller processes entries DIST pushes after it prefetched them)
+//  -- with DIST == 0 push hands every entry straight back and the queue is a no-op
+//
+template <typename T, size_t DIST>
+class PrefetchQueue
+{
+private:
+    T entries[DIST != 0 ? DIST : 1];
+    size_t head;
+    size_t count;
+
+public:
+    PrefetchQueue() noexcept : entries(), head(0), count(0) { }
+
+    inline bool isEmpty() const noexcept
+    {
+        return this->count == 0;
+    }
+
+    //true if an entry came out (in out) to be processed now
+    inline bool push(T v, T& out) noexcept
+    {
+        if constexpr(DIST == 0) {
+            out = v;
+            return true;
+        }
+        else {
+            size_t tail = (this->head + this->count) % DIST;
+            if(this->count != DIST) {
+                this->entries[tail] = v;
+                this->count++;
+                return false;
+            }
+
+            out = this->entries[this->head];
+            this->entries[this->head] = v;
+            this->head = (this->head + 1) % DIST;
+            return true;
+        }
+    }
+
+    //Oldest entry (for draining) -- false if empty
+    inline bool pop(T& out) noexcept
+    {
+        if constexpr(DIST == 0) {
+            return false;
+        }
+        else {
+            if(this->count == 0) {
+                return false;
+            }
+
+            out = this->entries[this->head];
+            this->head = (this->head + 1) % DIST;
+            this->count--;
+            return true;
+        }
+    }
+};
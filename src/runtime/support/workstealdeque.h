@@ -0,0 +1,104 @@
+#pragma once
+
+#include "xalloc.h"
+
+#include <atomic>
+#include <bit>
+
+//
+//A fixed capacity Chase-Lev work stealing deque (with the C11 orderings from Le et al. "Correct and Efficient Work-Stealing for Weak Memory Models")
+//  -- Only the owner thread may push and pop (at the bottom), any thread may steal (from the top)
+//  -- The ring buffer is a single xalloc page so push fails when it is full and the owner has to keep the entry somewhere private
+//  -- Entries are pointers and nullptr is reserved to mean empty (or a lost steal race)
+//
+template <typename T>
+class WorkStealingDeque
+{
+private:
+    constexpr static int64_t CAPACITY = (int64_t)std::bit_floor(BSQ_XALLOC_PAGE_SIZE / sizeof(std::atomic<T*>));
+    constexpr static int64_t INDEX_MASK = CAPACITY - 1;
+
+    std::atomic<int64_t> top;
+    std::atomic<int64_t> bottom;
+    std::atomic<T*>* buffer;
+
+public:
+    WorkStealingDeque() noexcept : top(0), bottom(0), buffer(nullptr) { }
+
+    void initialize() noexcept
+    {
+        this->top.store(0, std::memory_order_relaxed);
+        this->bottom.store(0, std::memory_order_relaxed);
+        this->buffer = (std::atomic<T*>*)XAllocPageManager::g_page_manager.allocatePage();
+    }
+
+    void clear() noexcept
+    {
+        XAllocPageManager::g_page_manager.freePage(this->buffer);
+        this->buffer = nullptr;
+    }
+
+    inline bool isEmpty() const noexcept
+    {
+        return this->bottom.load(std::memory_order_acquire) <= this->top.load(std::memory_order_acquire);
+    }
+
+    //Owner only -- false if the deque is full
+    inline bool push(T* v) noexcept
+    {
+        int64_t b = this->bottom.load(std::memory_order_relaxed);
+        int64_t t = this->top.load(std::memory_order_acquire);
+        if(b - t >= CAPACITY) [[unlikely]] {
+            return false;
+        }
+
+        this->buffer[b & INDEX_MASK].store(v, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //Owner only -- nullptr if the deque is empty (or a thief took the last entry)
+    inline T* pop() noexcept
+    {
+        int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+        this->bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = this->top.load(std::memory_order_relaxed);
+
+        if(t > b) {
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* v = this->buffer[b & INDEX_MASK].load(std::memory_order_relaxed);
+        if(t == b) {
+            //Last entry -- race any thieves for it
+            if(!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                v = nullptr;
+            }
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return v;
+    }
+
+    //Any thread -- nullptr if the deque is empty or another thread won the race for the top entry
+    inline T* steal() noexcept
+    {
+        int64_t t = this->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = this->bottom.load(std::memory_order_acquire);
+
+        if(t >= b) {
+            return nullptr;
+        }
+
+        T* v = this->buffer[t & INDEX_MASK].load(std::memory_order_relaxed);
+        if(!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        return v;
+    }
+};
@@ -9,10 +9,10 @@ void* XAllocPageManager::allocatePage_impl() noexcept
     if(this->freelist == NULL)
     {
 #ifndef ALLOC_DEBUG_MEM_DETERMINISTIC
-        this->freelist = (XAllocPage*)mmap(NULL, BSQ_BLOCK_ALLOCATION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+        this->freelist = (XAllocPage*)mmap(NULL, BSQ_XALLOC_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
 #else
-        this->freelist = (XAllocPage*)mmap(GlobalThreadAllocInfo::s_current_page_address, BSQ_BLOCK_ALLOCATION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, 0, 0);
-        GlobalThreadAllocInfo::s_current_page_address = (void*)((uint8_t*)GlobalThreadAllocInfo::s_current_page_address + BSQ_BLOCK_ALLOCATION_SIZE);
+        this->freelist = (XAllocPage*)mmap(GlobalThreadAllocInfo::s_current_page_address, BSQ_XALLOC_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, 0, 0);
+        GlobalThreadAllocInfo::s_current_page_address = (void*)((uint8_t*)GlobalThreadAllocInfo::s_current_page_address + BSQ_XALLOC_PAGE_SIZE);
 #endif
         assert(this->freelist != MAP_FAILED);
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+//Copy and fill kernels behind xmem_copy, xmem_zerofill and xmem_zerofillpage (see common.h) -- sizes are in 8 byte words and every pointer is 8 byte aligned
+//  -- the scalar loops are used for fills and larger copies (the compiler vectorizes them and hand written AVX2 versions were no faster)
+//  -- copies of at most XMEM_SMALL_COPY_WORDS words (every size class up to 64 bytes) get a fully unrolled copy for their exact size
+//
+
+#define XMEM_SMALL_COPY_WORDS 8ul
+
+inline void xmem_zerofill_scalar(void* mem, size_t n) noexcept
+{
+    void** obj = (void**)mem;
+    void** end = obj + n;
+    while(obj < end) {
+        *obj = nullptr;
+        obj++;
+    }
+}
+
+inline void xmem_copy_scalar(void* memsrc, void* memtrgt, size_t n) noexcept
+{
+    void** objsrc = (void**)memsrc;
+    void** objend = objsrc + n;
+    void** objtrgt = (void**)memtrgt;
+    while(objsrc < objend) {
+        *objtrgt = *objsrc;
+        objsrc++;
+        objtrgt++;
+    }
+}
+
+//Copy of exactly N words (never overlapping) -- a constant sized memcpy is lowered to straight line (vector) moves where a word loop is kept as a loop
+template <size_t N>
+inline void xmem_copy_fixed(void* memsrc, void* memtrgt) noexcept
+{
+    __builtin_memcpy(memtrgt, memsrc, N * sizeof(void*));
+}
+
+//n must be at most XMEM_SMALL_COPY_WORDS
+inline void xmem_copy_small(void* memsrc, void* memtrgt, size_t n) noexcept
+{
+    switch(n) {
+        case 0: break;
+        case 1: xmem_copy_fixed<1>(memsrc, memtrgt); break;
+        case 2: xmem_copy_fixed<2>(memsrc, memtrgt); break;
+        case 3: xmem_copy_fixed<3>(memsrc, memtrgt); break;
+        case 4: xmem_copy_fixed<4>(memsrc, memtrgt); break;
+        case 5: xmem_copy_fixed<5>(memsrc, memtrgt); break;
+        case 6: xmem_copy_fixed<6>(memsrc, memtrgt); break;
+        case 7: xmem_copy_fixed<7>(memsrc, memtrgt); break;
+        default: xmem_copy_fixed<8>(memsrc, memtrgt); break;
+    }
+}
@@ -0,0 +1,141 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+//
+//Cache misses per edge for the mark/evacuate and decrement loops on a graph whose edges point all over the heap.
+//Build it once as is and once with -DBSQ_GC_PREFETCH_DISTANCE=0 (e.g. make BUILD=release CFLAGS_OPT.release="-O2 -march=x86-64-v3 -DBSQ_GC_PREFETCH_DISTANCE=0") to compare.
+//    usage: gc_prefetch_bench [nodes]
+//
+
+struct TypeInfoBase GraphNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "111",
+    .typekey = "GraphNodeType"
+};
+
+struct GraphNode {
+    GraphNode* prev; //keeps every node reachable from the last one
+    GraphNode* a;
+    GraphNode* b;
+};
+
+void* garray[1] = {nullptr};
+
+//Hardware cache miss counter for this thread -- -1 if perf events are not available here
+int openMissCounter() {
+    struct perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+uint64_t readMisses(int fd) {
+    uint64_t count = 0;
+    if(fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+        return 0;
+    }
+    return count;
+}
+
+struct PhaseResult
+{
+    uint64_t misses;
+    double ms;
+};
+
+template <typename F>
+PhaseResult measure(int fd, F phase) {
+    if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+
+    phase();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    if(fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    return { readMisses(fd), std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count() };
+}
+
+void report(const char* name, const PhaseResult& res, size_t edges, int fd) {
+    std::cout << name << ": " << res.ms << " ms";
+    if(fd >= 0) {
+        std::cout << ", " << res.misses << " cache misses, " << ((double)res.misses / (double)edges) << " misses/edge";
+    }
+    std::cout << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t nodes = (argc > 1) ? (size_t)atoi(argv[1]) : 262144;
+
+    INIT_LOCKS();
+    REGISTER_TYPE(&GraphNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    //Every node points to the one before it and to two random earlier ones -- a DAG with edges spread over the whole heap
+    GraphNode** nodelist = (GraphNode**)malloc(nodes * sizeof(GraphNode*));
+    uint64_t rng = 0x9E3779B97F4A7C15ul;
+    size_t edges = 0;
+    for(size_t i = 0; i < nodes; i++) {
+        GraphNode* n = AllocTypeAuto(GraphNode, &GraphNodeType);
+        n->prev = (i != 0) ? nodelist[i - 1] : nullptr;
+
+        rng = rng * 6364136223846793005ul + 1442695040888963407ul;
+        n->a = (i != 0) ? nodelist[(rng >> 33) % i] : nullptr;
+        rng = rng * 6364136223846793005ul + 1442695040888963407ul;
+        n->b = (i != 0) ? nodelist[(rng >> 33) % i] : nullptr;
+
+        edges += (i != 0) ? 3 : 0;
+        nodelist[i] = n;
+    }
+    garray[0] = nodelist[nodes - 1];
+    free(nodelist);
+
+    int fd = openMissCounter();
+    std::cout << nodes << " nodes, " << edges << " edges, prefetch distance " << BSQ_GC_PREFETCH_DISTANCE << "\n";
+    if(fd < 0) {
+        std::cout << "(hardware cache miss counter not available -- times only)\n";
+    }
+
+    //Young collection -- marks and evacuates the whole graph
+    PhaseResult young = measure(fd, []() { collect(); });
+    assert(gtl_info.total_live_bytes == nodes * GraphNodeType.type_size);
+    report("mark + evacuate", young, edges, fd);
+
+    //Drop the (now old) graph -- every edge is one decrement
+    garray[0] = nullptr;
+    PhaseResult decs = measure(fd, []() {
+        collect();
+        while(!gtl_info.pending_decs.isEmpty()) {
+            collect();
+        }
+    });
+    assert(gtl_info.total_live_bytes == 0);
+    report("decrement", decs, edges, fd);
+
+    if(fd >= 0) {
+        close(fd);
+    }
+    return 0;
+}
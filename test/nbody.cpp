@@ -62,10 +62,6 @@ typedef struct {
     double mass;
 } Body;
 
-GCAllocator alloc3(24, REAL_ENTRY_SIZE(24), collect);
-GCAllocator alloc4(32, REAL_ENTRY_SIZE(32), collect);
-GCAllocator alloc5(40, REAL_ENTRY_SIZE(40), collect);
-
 #define N 5
 #define PI 3.141592653589793
 #define SOLAR_MASS (4 * PI * PI)
@@ -158,14 +154,14 @@ double distance(Body* b0, Body* b1)
 
 Body* createBody(Position p, Velocity v, uint64_t n, double m) 
 {
-    Body* b = AllocType(Body, alloc4, &CelestialBodyType);
+    Body* b = AllocTypeAuto(Body, &CelestialBodyType);
 
     //handle potential collection trigger preventing invalid metadata access
     b->pos = nullptr;
     b->vel = nullptr;
 
-    b->pos = AllocType(Position, alloc3, &PositionType);
-    b->vel = AllocType(Velocity, alloc3, &VelocityType);
+    b->pos = AllocTypeAuto(Position, &PositionType);
+    b->vel = AllocTypeAuto(Velocity, &VelocityType);
     
     b->name = n;
     b->mass = m;
@@ -180,7 +176,7 @@ Body* createBody(Position p, Velocity v, uint64_t n, double m)
 }
 
 Body** createNBodySystem() {
-    Body** planets = AllocType(Body*, alloc5, &ListNode5Type);
+    Body** planets = AllocTypeAuto(Body*, &ListNode5Type);
 
     planets[0] = createBody(jupiter_pos, jupiter_velocity, 0, jupiter_mass);
     planets[1] = createBody(saturn_position, saturn_velocity, 1, saturn_mass);
@@ -265,7 +261,7 @@ Body** advance(Body** planets, double dt)
     if (planets == nullptr) {
         assert(false);
     }
-    Body** new_planets = AllocType(Body*, alloc5, &ListNode5Type);
+    Body** new_planets = AllocTypeAuto(Body*, &ListNode5Type);
     new_planets[0] = nullptr;
     new_planets[1] = nullptr;
     new_planets[2] = nullptr;
@@ -296,15 +292,16 @@ Body** advance(Body** planets, double dt)
 int main(int argc, char** argv) 
 {
     INIT_LOCKS();
+    REGISTER_TYPE(&CelestialBodyType);
+    REGISTER_TYPE(&VelocityType);
+    REGISTER_TYPE(&PositionType);
+    REGISTER_TYPE(&ListNode5Type);
     GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
 
     InitBSQMemoryTheadLocalInfo();
     gtl_info.disable_automatic_collections = true;
     gtl_info.disable_stack_refs_for_tests = true;
 
-    GCAllocator* allocs[3] = { &alloc3, &alloc4, &alloc5 };
-    gtl_info.initializeGC<3>(allocs);
-
     int n = 50000000;
     Body** sys = createNBodySystem();
     double step = 0.01;
@@ -315,7 +312,7 @@ int main(int argc, char** argv)
     //is hardly any decrements happening, everything is just garbage
     for(int i = 0; i < n; i++) {
         sys = advance(sys, step);
-        int filled_count = gtl_info.newly_filled_pages_count;
+        uint32_t filled_count = gtl_info.newly_filled_pages_count;
         if(filled_count >= BSQ_COLLECTION_THRESHOLD) {
             collect();
         }
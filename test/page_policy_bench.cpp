@@ -0,0 +1,132 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+#include <iostream>
+#include <stdlib.h>
+
+//
+//Page selection policy benchmark -- runs the same fragmenting workload under each policy and reports the pages in use and the fragmentation.
+//Lists with random lifetimes are replaced in a ring of roots so pages are left at mixed utilization between collections.
+//    usage: page_policy_bench [rounds] [list length]
+//
+
+struct TypeInfoBase ListNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "100",
+    .typekey = "ListNodeType"
+};
+
+struct ListNode {
+    ListNode* next;
+    int64_t val;
+    int64_t pad;
+};
+
+#define RING_SIZE 64
+#define WARMUP_ROUNDS 16
+
+void* garray[RING_SIZE];
+
+GCAllocator alloc3(24, REAL_ENTRY_SIZE(24), collect);
+
+ListNode* makeList(int64_t length) {
+    ListNode* head = nullptr;
+    for(int64_t i = length - 1; i >= 0; i--) {
+        ListNode* n = AllocType(ListNode, alloc3, &ListNodeType);
+        n->next = head;
+        n->val = i;
+        n->pad = 0;
+        head = n;
+    }
+
+    return head;
+}
+
+struct PolicyResult
+{
+    uint64_t peak_pages;
+    double avg_pages;
+    double avg_frag;
+};
+
+const char* policyName(uint8_t policy) {
+    switch(policy) {
+        case PAGE_SELECT_LOWEST_UTIL: return "lowest-util";
+        case PAGE_SELECT_FULLEST_FIRST: return "fullest-first";
+        case PAGE_SELECT_BEST_FIT: return "best-fit";
+        default: return "address-ordered";
+    }
+}
+
+PolicyResult runPolicy(uint8_t policy, size_t rounds, size_t length) {
+    gtl_info.setPageSelectionPolicy(policy, policy);
+    assert(alloc3.getAllocPolicy() == policy && alloc3.getEvacPolicy() == policy);
+
+    //Same sequence of list replacements for every policy
+    uint64_t rng = 0x9E3779B97F4A7C15ul;
+    PolicyResult res = { 0, 0.0, 0.0 };
+    size_t samples = 0;
+
+    for(size_t i = 0; i < rounds; i++) {
+        rng = rng * 6364136223846793005ul + 1442695040888963407ul;
+        size_t slot = (rng >> 33) % RING_SIZE;
+        garray[slot] = makeList((int64_t)(1 + (rng >> 17) % length));
+
+        collect();
+
+        if(i >= WARMUP_ROUNDS) {
+            uint64_t inuse = gtl_info.total_gc_pages - gtl_info.total_empty_gc_pages;
+            res.peak_pages = std::max(res.peak_pages, inuse);
+            res.avg_pages += (double)inuse;
+            res.avg_frag += (inuse != 0) ? 1.0 - ((double)gtl_info.total_live_bytes / (double)(inuse * BSQ_BLOCK_ALLOCATION_SIZE)) : 0.0;
+            samples++;
+        }
+    }
+
+    if(samples != 0) {
+        res.avg_pages /= (double)samples;
+        res.avg_frag /= (double)samples;
+    }
+
+    //Drop the heap so the next policy starts from empty pages
+    for(size_t i = 0; i < RING_SIZE; i++) {
+        garray[i] = nullptr;
+    }
+    //Decrements are bounded per collection so dropping a big heap takes a few
+    collect();
+    collect();
+    for(size_t i = 0; i < 1024 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    return res;
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = (argc > 1) ? (size_t)atoi(argv[1]) : 256;
+    size_t length = (argc > 2) ? (size_t)atoi(argv[2]) : 2048;
+
+    INIT_LOCKS();
+    REGISTER_TYPE(&ListNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    //Policies set before the allocator is registered are picked up by initializeGC
+    gtl_info.setPageSelectionPolicy(PAGE_SELECT_BEST_FIT, PAGE_SELECT_FULLEST_FIRST);
+    GCAllocator* allocs[1] = { &alloc3 };
+    gtl_info.initializeGC<1>(allocs);
+    assert(alloc3.getAllocPolicy() == PAGE_SELECT_BEST_FIT && alloc3.getEvacPolicy() == PAGE_SELECT_FULLEST_FIRST);
+
+    std::cout << rounds << " rounds, lists up to " << length << " nodes, " << BSQ_BLOCK_ALLOCATION_SIZE << " byte pages\n";
+    for(uint8_t policy = 0; policy < PAGE_SELECT_POLICY_COUNT; policy++) {
+        PolicyResult res = runPolicy(policy, rounds, length);
+        std::cout << policyName(policy) << ": peak pages " << res.peak_pages << ", avg pages " << res.avg_pages << ", avg fragmentation " << res.avg_frag << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <format>
+
+struct TypeInfoBase ListNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "ListNodeType"
+};
+
+struct TypeInfoBase ItemType = {
+    .type_id = 2,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "000",
+    .typekey = "ItemType"
+};
+
+struct ListNode {
+    ListNode* next;
+    void* item;
+    int64_t val;
+};
+
+struct Item {
+    int64_t val;
+    int64_t pad1;
+    int64_t pad2;
+};
+
+#define LIST_LENGTH 16384
+#define KEEP_EVERY 8
+
+ListNode* makeList(int64_t length) {
+    ListNode* head = nullptr;
+    for(int64_t i = length - 1; i >= 0; i--) {
+        Item* item = AllocTypeAuto(Item, &ItemType);
+        item->val = i;
+        item->pad1 = 0;
+        item->pad2 = 0;
+
+        ListNode* n = AllocTypeAuto(ListNode, &ListNodeType);
+        n->next = head;
+        n->item = item;
+        n->val = i;
+        head = n;
+    }
+
+    return head;
+}
+
+//A second list that shares every KEEP_EVERY'th item of the first one
+ListNode* makeKeepList(ListNode* list) {
+    ListNode* head = nullptr;
+    ListNode* tail = nullptr;
+    for(ListNode* cur = list; cur != nullptr; cur = cur->next) {
+        if(cur->val % KEEP_EVERY != 0) {
+            continue;
+        }
+
+        ListNode* n = AllocTypeAuto(ListNode, &ListNodeType);
+        n->next = nullptr;
+        n->item = cur->item;
+        n->val = cur->val;
+
+        if(tail == nullptr) {
+            head = n;
+        }
+        else {
+            tail->next = n;
+        }
+        tail = n;
+    }
+
+    return head;
+}
+
+std::string printlist(ListNode* list) {
+    std::string res;
+    for(ListNode* cur = list; cur != nullptr; cur = cur->next) {
+        res += "[" + std::to_string(cur->val) + ", " + std::to_string(((Item*)cur->item)->val) + "]";
+    }
+
+    return res;
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Drop most of the items so their pages are left sparse then check that compaction consolidates them without breaking any references
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&ListNodeType);
+    REGISTER_TYPE(&ItemType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.enable_old_compaction = true;
+
+    ListNode* list = makeList(LIST_LENGTH);
+    garray[0] = list;
+    garray[1] = makeKeepList(list);
+    collect();
+
+    auto keep_start = printlist((ListNode*)garray[1]);
+    uint64_t keep_bytes = 2 * (LIST_LENGTH / KEEP_EVERY) * 24;
+
+    //Dropping the full list takes a few collections to process all of the decrements -- compaction only runs once they are done
+    garray[0] = nullptr;
+    for(size_t i = 0; i < 16; i++) {
+        collect();
+
+#ifdef BSQ_GC_LAZY_SWEEP
+        //Only swept pages are candidates for compaction
+        for(size_t j = 0; j < BSQ_MAX_ALLOC_SLOTS; j++) {
+            if(gtl_info.g_gcallocs[j] != nullptr) {
+                gtl_info.g_gcallocs[j]->sweepUnsweptPages(SIZE_MAX);
+            }
+        }
+#endif
+    }
+
+    assert(keep_start == printlist((ListNode*)garray[1]));
+    assert(gtl_info.total_live_bytes == keep_bytes);
+
+#if BSQ_BLOCK_ALLOCATION_SIZE_LOG2 <= 16
+    //Every surviving item was on a sparse page
+    assert(gtl_info.total_compacted_objects != 0);
+    assert(gtl_info.total_gc_pages - gtl_info.total_empty_gc_pages <= 2 * ((keep_bytes * 2) / BSQ_BLOCK_ALLOCATION_SIZE + 1));
+#endif
+
+    garray[1] = nullptr;
+    for(size_t i = 0; i < 4; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase ItemType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "000",
+    .typekey = "ItemType"
+};
+
+#define KEEPER_COUNT 8
+
+struct TypeInfoBase HolderType = {
+    .type_id = 2,
+    .type_size = KEEPER_COUNT * 8,
+    .slot_size = KEEPER_COUNT,
+    .ptr_mask = "11111111",
+    .typekey = "HolderType"
+};
+
+struct Item {
+    int64_t val;
+    int64_t pad1;
+    int64_t pad2;
+};
+
+struct Holder {
+    Item* keepers[KEEPER_COUNT];
+};
+
+Item* makeItem(int64_t val) {
+    Item* item = AllocTypeAuto(Item, &ItemType);
+    item->val = val;
+    item->pad1 = 0;
+    item->pad2 = 0;
+
+    return item;
+}
+
+std::string printkeepers(Holder* holder) {
+    std::string res;
+    for(size_t i = 0; i < KEEPER_COUNT; i++) {
+        res += "[" + std::to_string(holder->keepers[i]->val) + "]";
+    }
+
+    return res;
+}
+
+void collectAndSweep() {
+    collect();
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Only swept pages are candidates for compaction
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(gtl_info.g_gcallocs[i] != nullptr) {
+            gtl_info.g_gcallocs[i]->sweepUnsweptPages(SIZE_MAX);
+        }
+    }
+#endif
+}
+
+void* garray[KEEPER_COUNT + 1] = {};
+
+//
+//Keepers pinned in place on pages that are otherwise dead young objects -- compaction must move only the keepers and not the dead slots around them
+//(with the alloc bitmaps the headers of dead young slots are never reset so only the old bits say what is live)
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&ItemType);
+    //HolderType is left unregistered -- its layout is compiled on first allocate and the keepers are only reachable through it
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.enable_old_compaction = true;
+
+    //A page worth of garbage before each keeper so every keeper is alone on its page
+    size_t entrycount = PageInfo::computeEntryCount(REAL_ENTRY_SIZE(getSizeClassBytes(getSizeClassIndex(ItemType.type_size))));
+    for(size_t k = 0; k < KEEPER_COUNT; k++) {
+        for(size_t i = 0; i < entrycount; i++) {
+            makeItem(-1);
+        }
+        garray[k + 1] = makeItem((int64_t)k);
+    }
+
+    //The keepers are roots so they are promoted in place and the garbage around them dies young
+    collectAndSweep();
+
+    //Hand the keepers over to a holder so they stop being roots (and can be moved)
+    Holder* holder = AllocTypeAuto(Holder, &HolderType);
+    assert(HolderType.layout_kind == PTR_LAYOUT_BITMAP);
+    for(size_t k = 0; k < KEEPER_COUNT; k++) {
+        holder->keepers[k] = (Item*)garray[k + 1];
+        garray[k + 1] = nullptr;
+    }
+    garray[0] = holder;
+    auto keep_start = printkeepers(holder);
+
+    uint64_t compacted_start = gtl_info.total_compacted_objects;
+    for(size_t i = 0; i < 4; i++) {
+        collectAndSweep();
+    }
+
+    assert(keep_start == printkeepers((Holder*)garray[0]));
+    assert(gtl_info.total_compacted_objects - compacted_start == KEEPER_COUNT);
+    assert(gtl_info.total_live_bytes == KEEPER_COUNT * ItemType.type_size + HolderType.type_size);
+
+    garray[0] = nullptr;
+    for(size_t i = 0; i < 4; i++) {
+        collectAndSweep();
+    }
+
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase TreeNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "TreeNodeType"
+};
+
+struct TreeNodeValue {
+    TreeNodeValue* left;
+    TreeNodeValue* right;
+    int64_t val;
+};
+
+#define RING_SIZE 8
+#define ROUNDS 32
+
+TreeNodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    TreeNodeValue* n = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+uint64_t treeBytes(int64_t depth) {
+    return (((uint64_t)1 << (depth + 1)) - 1) * TreeNodeType.type_size;
+}
+
+std::string printtree(TreeNodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+TreeNodeValue* garray[RING_SIZE + 1];
+
+//
+//Concurrent marking -- every round seeds a cycle, keeps building (and dropping) trees while the background thread marks
+//and stores new subtrees into a parent the marker may have scanned already, then finishes the cycle with a collection
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&TreeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.setConcurrentMarking(true);
+
+    std::string expected[RING_SIZE];
+    for(size_t i = 0; i < RING_SIZE; i++) {
+        garray[i] = makeTree(9, 1000 * i);
+        expected[i] = printtree(garray[i]);
+    }
+
+    for(int64_t round = 0; round < ROUNDS; round++) {
+        TreeNodeValue* parent = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+        parent->val = -round;
+        parent->left = nullptr;
+        parent->right = nullptr;
+        garray[RING_SIZE] = parent;
+
+        incrementalMarkStep();
+        assert(gtl_info.concurrent_mark_running);
+        assert(gtl_info.gc_workers.threads != 0); //the marker is a parked pool worker and not a thread per cycle
+
+        //Replace a young tree (marked by the snapshot) with a new one the marker never sees
+        size_t slot = (size_t)round % RING_SIZE;
+        garray[slot] = makeTree(9, 1000 * slot + round);
+        expected[slot] = printtree(garray[slot]);
+
+        GC_WRITE_BARRIER(&parent->left, makeTree(5, 100 * round));
+        GC_WRITE_BARRIER(&parent->right, garray[(slot + 1) % RING_SIZE]->left);
+        auto pstr = printtree(parent);
+
+        collect();
+        assert(!gtl_info.concurrent_mark_running && !gtl_info.incremental_mark_active);
+
+        assert(pstr == printtree(garray[RING_SIZE]));
+        for(size_t i = 0; i < RING_SIZE; i++) {
+            assert(expected[i] == printtree(garray[i]));
+        }
+
+        //The dropped tree was promoted by the cycle as floating garbage -- the decrements of the same collection free it
+        assert(gtl_info.pending_decs.isEmpty());
+        assert(gtl_info.total_live_bytes == RING_SIZE * treeBytes(9) + TreeNodeType.type_size + treeBytes(5));
+    }
+
+    for(size_t i = 0; i <= RING_SIZE; i++) {
+        garray[i] = nullptr;
+    }
+    for(size_t i = 0; i < 16 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    //Thread teardown in the middle of a cycle waits for the marker and drops the cycle (its marks too) before stopping the pool
+    garray[0] = makeTree(9, 0);
+    incrementalMarkStep();
+    assert(gtl_info.concurrent_mark_running);
+
+    ReleaseBSQMemoryTheadLocalInfo();
+    assert(!gtl_info.concurrent_mark_running && !gtl_info.incremental_mark_active);
+    assert(gtl_info.gc_workers.threads == 0);
+    assert(!GC_IS_MARKED(garray[0]) && !GC_IS_MARKED(garray[0]->left));
+
+    return 0;
+}
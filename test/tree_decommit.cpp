@@ -0,0 +1,130 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <format>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if (depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->left = nullptr;
+    n->right = nullptr;
+    n->val = val;
+
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 1);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if (node == nullptr) {
+        return "null";
+    }
+
+    std::string addr = "xx";
+    std::string nodeStr = "[" + addr + ", " + std::to_string(node->val) + "]";
+
+    return nodeStr + ", " + printtree(node->left) + ", " + printtree(node->right);
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//Build a big tree, promote it, then drop it so all of its pages end up empty
+void spike(int64_t depth) {
+    garray[0] = makeTree(depth, 0);
+    collect();
+
+    garray[0] = nullptr;
+    collect();
+    collect();
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Empty pages only reach the page pool once they are swept
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(gtl_info.g_gcallocs[i] != nullptr) {
+            gtl_info.g_gcallocs[i]->sweepUnsweptPages(SIZE_MAX);
+        }
+    }
+#endif
+
+    //Pages parked in this thread's page cache are never decommitted so hand them back before the next collection
+    GlobalPageGCManager::g_gc_page_manager.flushPageCache(gtl_info);
+    collect();
+}
+
+//
+//Empty pages left over after a spike should be returned to the OS and then reused for later allocation
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    //No hot pool -- decommit every empty page right away
+    GlobalPageGCManager::g_gc_page_manager.setDecommitPolicy({ .min_pool_pages = 0, .min_age_ms = 0, .lazy_free = false, .background_interval_ms = 0 });
+
+    spike(14);
+    assert(gtl_info.total_live_bytes == 0);
+
+    size_t decommitted = GlobalPageGCManager::g_gc_page_manager.getDecommittedPageCount();
+    assert(decommitted != 0);
+
+    //Decommitted pages come back zeroed and are handed out before any fresh blocks
+    uint64_t total_pages = gtl_info.total_gc_pages;
+
+    NodeValue* t1 = makeTree(12, 0);
+    garray[1] = t1;
+    auto t1_start = printtree(t1);
+
+    assert(GlobalPageGCManager::g_gc_page_manager.getDecommittedPageCount() < decommitted);
+    assert(gtl_info.total_gc_pages == total_pages);
+
+    collect();
+    assert(t1_start == printtree((NodeValue*)garray[1]));
+
+    garray[1] = nullptr;
+
+    //Now let the background thread do the decommits
+    GlobalPageGCManager::g_gc_page_manager.setDecommitPolicy({ .min_pool_pages = 0, .min_age_ms = 0, .lazy_free = true, .background_interval_ms = 1 });
+    assert(GlobalPageGCManager::g_gc_page_manager.isBackgroundDecommitEnabled());
+
+    size_t before_bg = GlobalPageGCManager::g_gc_page_manager.getDecommittedPageCount();
+    spike(14);
+
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = 50 * 1000000l };
+    thrd_sleep(&ts, NULL);
+
+    GlobalPageGCManager::g_gc_page_manager.setDecommitPolicy({ .min_pool_pages = 0, .min_age_ms = 0, .lazy_free = false, .background_interval_ms = 0 });
+    assert(!GlobalPageGCManager::g_gc_page_manager.isBackgroundDecommitEnabled());
+
+    assert(GlobalPageGCManager::g_gc_page_manager.getDecommittedPageCount() > before_bg);
+    assert(gtl_info.total_live_bytes == 0);
+
+    //Thread teardown hands the cached pages back to the pool
+    ReleaseBSQMemoryTheadLocalInfo();
+    assert(gtl_info.page_cache.count == 0);
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <vector>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+void collectNodes(NodeValue* node, std::vector<NodeValue*>& nodes) {
+    if(node != nullptr) {
+        nodes.push_back(node);
+        collectNodes(node->left, nodes);
+        collectNodes(node->right, nodes);
+    }
+}
+
+void drainDecrements() {
+    collect();
+    for(size_t i = 0; i < 16 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Old objects freed by their ref counts are pushed on their page's freelist -- the entry has to be the start of the slot (before the
+//canary in debug builds) like the ones rebuild links, or the next allocation from the page hands out a shifted slot
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    garray[0] = makeTree(10, 0);
+    collect();
+
+    //Keep only the left subtree of every node valued 8 so the old pages are partly freed (and stay in the page sets)
+    std::vector<NodeValue*> dead;
+    NodeValue* holder = nullptr;
+    std::vector<NodeValue*> top;
+    collectNodes((NodeValue*)garray[0], top);
+    for(NodeValue* n : top) {
+        if(n->val == 8) {
+            collectNodes(n->right, dead);
+
+            NodeValue* h = AllocTypeAuto(NodeValue, &NodeType);
+            h->val = -1;
+            h->left = n->left;
+            h->right = holder;
+            holder = h;
+        }
+    }
+
+    garray[1] = holder;
+    garray[0] = nullptr;
+    drainDecrements();
+
+    auto kept = printtree((NodeValue*)garray[1]);
+
+#ifndef BSQ_GC_ALLOC_BITMAP
+    size_t checked = 0;
+    for(NodeValue* obj : dead) {
+        PageInfo* page = PageInfo::extractPageFromPointer(obj);
+        if(page->pageset == PAGE_SET_NONE) {
+            continue; //emptied (and back in the pool) or the current alloc page
+        }
+
+        //Every entry on the freelist is a slot start and the freed object's slot is one of them
+        FreeListEntry* slot = page->getFreelistEntryAtIndex(PageInfo::getIndexForObjectInPage(obj));
+        bool found = false;
+        for(FreeListEntry* entry = page->freelist; entry != nullptr; entry = entry->next) {
+            assert(((uint8_t*)entry - page->data) % page->realsize == 0);
+            found |= (entry == slot);
+        }
+        assert(found);
+        checked++;
+    }
+    assert(checked != 0);
+#endif
+
+    //Allocate out of the freed slots -- a shifted slot would overwrite the canaries and headers of its kept neighbors
+    garray[2] = makeTree(9, 3);
+    assert(kept == printtree((NodeValue*)garray[1]));
+
+    garray[1] = nullptr;
+    garray[2] = nullptr;
+    drainDecrements();
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
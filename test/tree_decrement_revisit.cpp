@@ -0,0 +1,98 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+void drainDecrements() {
+    collect();
+    for(size_t i = 0; i < 16 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+}
+
+//
+//Old pages emptied by a decrement round go back to the page pool (and are decommitted right away) -- each page must be visited once
+//per round so no page is revisited after it is in the pool and the freed pages can be handed out again
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    GlobalPageGCManager::g_gc_page_manager.setDecommitPolicy({ .min_pool_pages = 0, .min_age_ms = 0, .lazy_free = false, .background_interval_ms = 0 });
+
+    for(int64_t round = 0; round < 4; round++) {
+        //Every page of the tree holds many old objects that all die in the same decrement round
+        garray[0] = makeTree(12, 100 * round);
+        collect();
+
+        //Keep one subtree so its pages are only partly freed and move between page sets instead of going to the pool
+        garray[1] = ((NodeValue*)garray[0])->left->right;
+        auto kept = printtree((NodeValue*)garray[1]);
+
+        garray[0] = nullptr;
+        drainDecrements();
+        GlobalPageGCManager::g_gc_page_manager.flushPageCache(gtl_info);
+
+        assert(kept == printtree((NodeValue*)garray[1]));
+
+        garray[1] = nullptr;
+        drainDecrements();
+        GlobalPageGCManager::g_gc_page_manager.flushPageCache(gtl_info);
+
+        assert(gtl_info.total_live_bytes == 0);
+    }
+
+    //The pages that were returned (and decommitted) are reused for the next tree
+    assert(GlobalPageGCManager::g_gc_page_manager.getDecommittedPageCount() != 0);
+
+    NodeValue* t = makeTree(12, 7);
+    garray[2] = t;
+    auto t_start = printtree(t);
+
+    collect();
+    assert(t_start == printtree((NodeValue*)garray[2]));
+
+    return 0;
+}
@@ -86,6 +86,7 @@ TreeNodeValue* garray[3] = {nullptr, nullptr, nullptr};
 //
 int main(int argc, char** argv) {
     INIT_LOCKS();
+    REGISTER_TYPE(&TreeNodeType);
     GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
 
     InitBSQMemoryTheadLocalInfo();
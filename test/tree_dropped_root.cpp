@@ -0,0 +1,105 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+uint64_t treeBytes(int64_t depth) {
+    return ((1ul << (depth + 1)) - 1) * getSizeClassBytes(getSizeClassIndex(NodeType.type_size));
+}
+
+void drainDecrements() {
+    collect();
+    for(size_t i = 0; i < 16 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//An old root that is dropped from the roots while another old object still points to it must stay alive (with its subtree) until
+//that last reference is gone -- then the decrements free it
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    NodeValue* shared = makeTree(8, 0);
+    NodeValue* parent = AllocTypeAuto(NodeValue, &NodeType);
+    parent->val = -1;
+    parent->left = shared;
+    parent->right = nullptr;
+
+    garray[0] = shared;
+    garray[1] = parent;
+    auto expected = printtree(parent);
+
+    collect();
+    assert(gtl_info.total_live_bytes == treeBytes(8) + treeBytes(0));
+
+    //Only the old parent keeps the subtree alive now
+    garray[0] = nullptr;
+    drainDecrements();
+
+    assert(expected == printtree((NodeValue*)garray[1]));
+    assert(gtl_info.total_live_bytes == treeBytes(8) + treeBytes(0));
+
+    //Reuse any slots that were (wrongly) freed and make sure the subtree was not overwritten
+    for(int64_t round = 0; round < 4; round++) {
+        garray[2] = makeTree(8, 100 + round);
+        collect();
+
+        assert(expected == printtree((NodeValue*)garray[1]));
+    }
+
+    garray[2] = nullptr;
+    drainDecrements();
+    assert(gtl_info.total_live_bytes == treeBytes(8) + treeBytes(0));
+
+    //Dropping the parent drops the last reference to the subtree
+    garray[1] = nullptr;
+    drainDecrements();
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase TreeNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "TreeNodeType"
+};
+
+struct TreeNodeValue {
+    TreeNodeValue* left;
+    TreeNodeValue* right;
+    int64_t val;
+};
+
+#define SLICE_OBJECTS 16
+
+TreeNodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    TreeNodeValue* n = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+uint64_t treeBytes(int64_t depth) {
+    return (((uint64_t)1 << (depth + 1)) - 1) * TreeNodeType.type_size;
+}
+
+std::string printtree(TreeNodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+TreeNodeValue* garray[4] = {nullptr, nullptr, nullptr, nullptr};
+
+//
+//Incremental marking driven by hand -- a parent that was scanned by a slice gets new children through the write barrier, a new tree is
+//rooted mid cycle and a tree that was marked by the seed scan is dropped before the final pause (it has to be freed by that collection)
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&TreeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.setIncrementalMarking(true, SLICE_OBJECTS);
+
+    garray[0] = makeTree(10, 0);
+    garray[2] = makeTree(8, 500);
+
+    TreeNodeValue* parent = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    parent->val = -1;
+    parent->left = nullptr;
+    parent->right = nullptr;
+    garray[1] = parent;
+
+    auto t0_start = printtree(garray[0]);
+
+    //Seed and run a couple of slices then store a new subtree into the parent (which may or may not be scanned yet)
+    incrementalMarkStep();
+    assert(gtl_info.incremental_mark_active);
+    incrementalMarkStep();
+    GC_WRITE_BARRIER(&parent->right, makeTree(4, 300));
+
+    //Finish the graph the cycle can see -- every slice is bounded so this takes many of them
+    size_t slices = 2;
+    while(!gtl_info.visit_stack.isEmpty()) {
+        incrementalMarkStep();
+        slices++;
+    }
+    assert(slices > (treeBytes(10) / TreeNodeType.type_size) / SLICE_OBJECTS);
+
+    //The parent is scanned now so only the barrier keeps this subtree alive
+    GC_WRITE_BARRIER(&parent->left, makeTree(6, 200));
+    garray[3] = makeTree(6, 400);
+    garray[2] = nullptr;
+
+    auto t1_start = printtree(garray[1]);
+    auto t3_start = printtree(garray[3]);
+
+    collect();
+    assert(!gtl_info.incremental_mark_active);
+
+    assert(t0_start == printtree(garray[0]));
+    assert(t1_start == printtree(garray[1]));
+    assert(t3_start == printtree(garray[3]));
+    assert(gtl_info.pending_decs.isEmpty());
+    assert(gtl_info.total_live_bytes == treeBytes(10) + TreeNodeType.type_size + treeBytes(6) + treeBytes(4) + treeBytes(6));
+
+    //A cycle over a heap that is all old -- only the tree built during it is young
+    incrementalMarkStep();
+    garray[2] = makeTree(5, 600);
+    auto t2_start = printtree(garray[2]);
+    garray[3] = nullptr;
+
+    collect();
+    assert(t0_start == printtree(garray[0]));
+    assert(t1_start == printtree(garray[1]));
+    assert(t2_start == printtree(garray[2]));
+
+    for(size_t i = 0; i < 4; i++) {
+        garray[i] = nullptr;
+    }
+    for(size_t i = 0; i < 8 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <format>
+#include <string.h>
+
+#define LARGE_NODE_SLOTS 1024
+
+struct TypeInfoBase SmallNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "SmallNodeType"
+};
+
+//mask is filled in main -- two pointers followed by scalar payload
+char large_node_mask[LARGE_NODE_SLOTS + 1];
+
+//bigger than a GC page so it goes to the large object space
+struct TypeInfoBase LargeNodeType = {
+    .type_id = 2,
+    .type_size = LARGE_NODE_SLOTS * 8,
+    .slot_size = LARGE_NODE_SLOTS,
+    .ptr_mask = large_node_mask,
+    .typekey = "LargeNodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if (depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, (depth % 2 == 0) ? &LargeNodeType : &SmallNodeType);
+    n->left = nullptr;
+    n->right = nullptr;
+    n->val = val;
+
+    if(GC_TYPE(n) == &LargeNodeType) {
+        //touch the end of the object to make sure the whole span is usable
+        ((int64_t*)n)[LARGE_NODE_SLOTS - 1] = val;
+        //an inline string (length in the low bits) so the collector must not follow it
+        ((uintptr_t*)n)[LARGE_NODE_SLOTS - 2] = 0x3;
+    }
+
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 1);
+
+    return n;
+}
+
+uint64_t treeBytes(NodeValue* node) {
+    if (node == nullptr) {
+        return 0;
+    }
+
+    return GC_TYPE(node)->type_size + treeBytes(node->left) + treeBytes(node->right);
+}
+
+uint64_t largeCount(NodeValue* node) {
+    if (node == nullptr) {
+        return 0;
+    }
+
+    return (GC_TYPE(node) == &LargeNodeType ? 1 : 0) + largeCount(node->left) + largeCount(node->right);
+}
+
+std::string printtree(NodeValue* node) {
+    if (node == nullptr) {
+        return "null";
+    }
+
+    std::string addr = "xx";
+    std::string nodeStr = "[" + addr + ", " + std::to_string(node->val) + "]";
+    if(GC_TYPE(node) == &LargeNodeType) {
+        nodeStr += "(" + std::to_string(((int64_t*)node)[LARGE_NODE_SLOTS - 1]) + ")";
+    }
+
+    return nodeStr + ", " + printtree(node->left) + ", " + printtree(node->right);
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Tree where every other level is a large object -- large objects should survive
+//collections in place and be unmapped once they die (young or old)
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&SmallNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    memset(large_node_mask, PTR_MASK_NOP, LARGE_NODE_SLOTS);
+    large_node_mask[0] = PTR_MASK_PTR;
+    large_node_mask[1] = PTR_MASK_PTR;
+    large_node_mask[LARGE_NODE_SLOTS - 2] = PTR_MASK_STRING; //past the bitmap slots so the type gets an offset list layout
+    large_node_mask[LARGE_NODE_SLOTS] = '\0';
+    REGISTER_TYPE(&LargeNodeType); //only once the mask is filled in
+    assert(LargeNodeType.layout_kind == PTR_LAYOUT_OFFSETS);
+
+    NodeValue* t1 = makeTree(6, 0);
+    garray[0] = t1;
+
+    //dies young
+    makeTree(4, 100);
+
+    NodeValue* large_root = t1;
+    assert(GC_TYPE(large_root) == &LargeNodeType);
+
+    uint64_t init_total_bytes = treeBytes(t1);
+    auto t1_start = printtree(t1);
+
+    collect();
+
+    //large objects are promoted in place
+    assert(garray[0] == large_root);
+    assert(t1_start == printtree(t1));
+    assert(init_total_bytes == gtl_info.total_live_bytes);
+
+    uint64_t live_span_bytes = gtl_info.total_large_object_bytes;
+    size_t spansize = GlobalPageGCManager::computeLargeObjectSpanSize(LargeNodeType.type_size);
+    assert(live_span_bytes == largeCount(t1) * spansize);
+
+    //Large objects count against the collection threshold by what they map and not as whole blocks (which are 2MB with BLOCK_LOG2=21)
+    assert(gtl_info.newly_large_object_bytes == 0 && gtl_info.newly_filled_pages_count == 0);
+    makeTree(0, 200);
+    makeTree(0, 201);
+    assert(gtl_info.newly_large_object_bytes == 2 * spansize && gtl_info.newly_filled_pages_count == 0);
+    assert(gtl_info.getNewlyAllocatedBytes() < BSQ_COLLECTION_THRESHOLD_BYTES);
+
+    //drop a large subtree from an old root
+    garray[1] = t1->left->left;
+    garray[0] = nullptr;
+    collect();
+    collect();
+
+    assert(gtl_info.total_live_bytes == treeBytes((NodeValue*)garray[1]));
+    assert(gtl_info.total_large_object_bytes < live_span_bytes);
+
+    garray[1] = nullptr;
+    collect();
+    collect();
+
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -208,6 +208,11 @@ void* garray[3] = {nullptr, nullptr, nullptr};
 //
 int main(int argc, char** argv) {
     INIT_LOCKS();
+    REGISTER_TYPE(&TreeNode1Type);
+    REGISTER_TYPE(&TreeNode2Type);
+    REGISTER_TYPE(&TreeNode3Type);
+    REGISTER_TYPE(&TreeNode4Type);
+    REGISTER_TYPE(&TreeNode5Type);
     GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
 
     InitBSQMemoryTheadLocalInfo();
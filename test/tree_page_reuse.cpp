@@ -0,0 +1,109 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+//Every other subtree at the given depth below node (left to right) is put on a (young) list so the rest of the tree can die around them
+NodeValue* keepAlternateSubtrees(NodeValue* node, int64_t depth, NodeValue* list, size_t& count) {
+    if(depth == 0) {
+        if(count++ % 2 == 0) {
+            NodeValue* holder = AllocTypeAuto(NodeValue, &NodeType);
+            holder->val = -1;
+            holder->left = node;
+            holder->right = list;
+            list = holder;
+        }
+        return list;
+    }
+
+    list = keepAlternateSubtrees(node->left, depth - 1, list, count);
+    return keepAlternateSubtrees(node->right, depth - 1, list, count);
+}
+
+void drainDecrements() {
+    collect();
+    for(size_t i = 0; i < 16 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Old objects that are only kept alive by other old objects (not roots and not marked) sit on partly freed pages -- when those pages are
+//reused from the page sets as alloc pages the rebuild after the next collection must keep them
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    garray[0] = makeTree(12, 0);
+    collect();
+
+    //Small (15 node) subtrees interleaved with dead ones so most of the old pages end up partly used
+    size_t count = 0;
+    garray[1] = keepAlternateSubtrees((NodeValue*)garray[0], 9, nullptr, count);
+    garray[0] = nullptr;
+    drainDecrements();
+
+    auto kept = printtree((NodeValue*)garray[1]);
+    uint64_t kept_bytes = gtl_info.total_live_bytes;
+
+    //Young garbage is allocated on the reused pages and they are rebuilt after every collection
+    for(int64_t round = 0; round < 8; round++) {
+        garray[2] = makeTree(10, round);
+        collect();
+
+        garray[2] = nullptr;
+        drainDecrements();
+
+        assert(kept == printtree((NodeValue*)garray[1]));
+        assert(gtl_info.total_live_bytes == kept_bytes);
+    }
+
+    garray[1] = nullptr;
+    drainDecrements();
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
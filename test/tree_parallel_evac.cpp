@@ -0,0 +1,154 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+//exactly a size class
+struct TypeInfoBase SmallNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "SmallNodeType"
+};
+
+//rounds up to the 288 byte class
+struct TypeInfoBase MediumNodeType = {
+    .type_id = 2,
+    .type_size = 264,
+    .slot_size = 33,
+    .ptr_mask = "110000000000000000000000000000000",
+    .typekey = "MediumNodeType"
+};
+
+//rounds up to the 640 byte class
+struct TypeInfoBase LargeNodeType = {
+    .type_id = 3,
+    .type_size = 600,
+    .slot_size = 75,
+    .ptr_mask = "110000000000000000000000000000000000000000000000000000000000000000000000000",
+    .typekey = "LargeNodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+TypeInfoBase* types[3] = { &SmallNodeType, &MediumNodeType, &LargeNodeType };
+
+#define EVAC_WORKERS 4
+#define TREE_COUNT 6
+#define TREE_DEPTH 11
+
+//Every other level shares one child between both sides -- so the fixups of different workers count references to the same objects
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, types[depth % 3]);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = (depth % 2 == 0) ? n->left : makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+uint64_t treeBytes(int64_t depth) {
+    if(depth < 0) {
+        return 0;
+    }
+
+    //live bytes are counted per size class slot
+    uint64_t sub = treeBytes(depth - 1);
+    return getSizeClassBytes(getSizeClassIndex(types[depth % 3]->type_size)) + ((depth % 2 == 0) ? sub : 2 * sub);
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+NodeValue* garray[TREE_COUNT + 1];
+
+//
+//Parallel evacuation of many young survivors in three size classes (many evacuation pages per worker) -- the trees have to survive
+//unchanged, live bytes have to be exact and the ref counts have to free everything once it is dropped
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&SmallNodeType);
+    REGISTER_TYPE(&MediumNodeType);
+    REGISTER_TYPE(&LargeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.setMarkWorkerCount(EVAC_WORKERS);
+
+    std::string expected[TREE_COUNT];
+    for(size_t i = 0; i < TREE_COUNT; i++) {
+        garray[i] = makeTree(TREE_DEPTH, 1000 * i);
+        expected[i] = printtree(garray[i]);
+    }
+
+    collect();
+
+    for(size_t i = 0; i < TREE_COUNT; i++) {
+        assert(expected[i] == printtree(garray[i]));
+    }
+    assert(gtl_info.total_live_bytes == TREE_COUNT * treeBytes(TREE_DEPTH));
+
+    //Young trees that point into the old ones (and replace half of them) -- copied in parallel into the partly freed old pages
+    for(size_t i = 0; i < TREE_COUNT; i += 2) {
+        garray[i] = makeTree(TREE_DEPTH, 1000 * i + 7);
+        expected[i] = printtree(garray[i]);
+    }
+
+    NodeValue* mixed = AllocTypeAuto(NodeValue, &SmallNodeType);
+    mixed->val = -1;
+    mixed->left = makeTree(TREE_DEPTH - 2, 500);
+    mixed->right = garray[1]->left;
+    garray[TREE_COUNT] = mixed;
+    auto mixed_start = printtree(garray[TREE_COUNT]);
+
+    //The replaced trees are freed by the decrements of this (and maybe the next few) collections
+    collect();
+    for(size_t i = 0; i < 8 && !gtl_info.pending_decs.isEmpty(); i++) {
+        collect();
+    }
+
+    for(size_t i = 0; i < TREE_COUNT; i++) {
+        assert(expected[i] == printtree(garray[i]));
+    }
+    assert(mixed_start == printtree(garray[TREE_COUNT]));
+    assert(gtl_info.total_live_bytes == TREE_COUNT * treeBytes(TREE_DEPTH) + SmallNodeType.type_size + treeBytes(TREE_DEPTH - 2));
+
+    for(size_t i = 0; i <= TREE_COUNT; i++) {
+        garray[i] = nullptr;
+    }
+    for(size_t i = 0; i < 16 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Empty pages only reach the page pool once they are swept
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(gtl_info.g_gcallocs[i] != nullptr) {
+            gtl_info.g_gcallocs[i]->sweepUnsweptPages(SIZE_MAX);
+        }
+    }
+#endif
+
+    //Every page the GC threads evacuated into was taken (and given back) through this thread's page cache and counts
+    assert(gtl_info.total_empty_gc_pages == gtl_info.total_gc_pages);
+
+    return 0;
+}
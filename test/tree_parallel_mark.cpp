@@ -0,0 +1,113 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <format>
+
+struct TypeInfoBase TreeNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "TreeNodeType"
+};
+
+struct TreeNodeValue {
+    TreeNodeValue* left;
+    TreeNodeValue* right;
+    int64_t val;
+};
+
+#define MARK_WORKERS 4
+#define TREE_DEPTH 12
+
+//
+//Tree where every other level shares one child between both sides -- so shared subtrees can be reached by different workers
+//
+TreeNodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    TreeNodeValue* n = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = (depth % 2 == 0) ? n->left : makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+size_t countNodes(int64_t depth) {
+    if(depth < 0) {
+        return 0;
+    }
+
+    size_t sub = countNodes(depth - 1);
+    return 1 + ((depth % 2 == 0) ? sub : 2 * sub);
+}
+
+std::string printtree(TreeNodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+TreeNodeValue* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Parallel marking of young trees with shared subtrees -- the trees have to survive unchanged and the ref counts have to free them exactly
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&TreeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+    gtl_info.setMarkWorkerCount(MARK_WORKERS);
+
+    garray[0] = makeTree(TREE_DEPTH, 0);
+    garray[1] = makeTree(TREE_DEPTH, 100);
+    auto t0_start = printtree(garray[0]);
+    auto t1_start = printtree(garray[1]);
+    uint64_t tree_bytes = countNodes(TREE_DEPTH) * TreeNodeType.type_size;
+
+    collect();
+
+    assert(t0_start == printtree(garray[0]));
+    assert(t1_start == printtree(garray[1]));
+    assert(gtl_info.total_live_bytes == 2 * tree_bytes);
+
+    //The GC threads stay parked in the pool between collections
+    assert(gtl_info.gc_workers.threads == MARK_WORKERS - 1);
+
+    //A young tree that points into the (now old) first one
+    TreeNodeValue* mixed = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    mixed->val = -1;
+    mixed->left = makeTree(TREE_DEPTH, 200);
+    mixed->right = garray[0]->left;
+    garray[2] = mixed;
+    auto t2_start = printtree(garray[2]);
+
+    garray[1] = nullptr;
+    collect();
+
+    assert(t0_start == printtree(garray[0]));
+    assert(t2_start == printtree(garray[2]));
+
+    garray[0] = nullptr;
+    garray[2] = nullptr;
+    for(size_t i = 0; i < 8 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+    assert(gtl_info.gc_workers.threads == MARK_WORKERS - 1);
+
+    ReleaseBSQMemoryTheadLocalInfo();
+    assert(gtl_info.gc_workers.threads == 0);
+
+    return 0;
+}
@@ -102,6 +102,8 @@ void* garray[3] = {nullptr, nullptr, nullptr};
 int main(int argc, char **argv)
 {
     INIT_LOCKS();
+    REGISTER_TYPE(&TreeNode3Type);
+    REGISTER_TYPE(&TreeNode1Type);
     GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
 
     InitBSQMemoryTheadLocalInfo();
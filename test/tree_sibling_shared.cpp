@@ -0,0 +1,92 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+
+struct TypeInfoBase TreeNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "TreeNodeType"
+};
+
+struct TreeNodeValue {
+    TreeNodeValue* left;
+    TreeNodeValue* right;
+    int64_t val;
+};
+
+#define CHAIN_LENGTH 256
+
+//
+//Chain of triangles where the right child also points at its left sibling -- when the right child is scanned the left one is marked but not scanned yet
+//
+TreeNodeValue* makeChain(int64_t length) {
+    TreeNodeValue* next = nullptr;
+    for(int64_t i = 0; i < length; i++) {
+        TreeNodeValue* shared = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+        shared->left = next;
+        shared->right = nullptr;
+        shared->val = 3 * i;
+
+        TreeNodeValue* sibling = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+        sibling->left = shared;
+        sibling->right = nullptr;
+        sibling->val = 3 * i + 1;
+
+        TreeNodeValue* parent = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+        parent->left = shared;
+        parent->right = sibling;
+        parent->val = 3 * i + 2;
+
+        next = parent;
+    }
+
+    return next;
+}
+
+bool checkChain(TreeNodeValue* node, int64_t length) {
+    for(int64_t i = length - 1; i >= 0; i--) {
+        if(node == nullptr || node->val != 3 * i + 2 || GC_TYPE(node) != &TreeNodeType) {
+            return false;
+        }
+
+        TreeNodeValue* shared = node->left;
+        TreeNodeValue* sibling = node->right;
+        if(sibling->left != shared || shared->val != 3 * i || sibling->val != 3 * i + 1 || GC_TYPE(shared) != &TreeNodeType) {
+            return false;
+        }
+
+        node = shared->left;
+    }
+
+    return node == nullptr;
+}
+
+TreeNodeValue* garray[1] = {nullptr};
+
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&TreeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), (void**)garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    garray[0] = makeChain(CHAIN_LENGTH);
+
+    collect();
+    assert(checkChain(garray[0], CHAIN_LENGTH));
+    assert(gtl_info.total_live_bytes == 3 * CHAIN_LENGTH * TreeNodeType.type_size);
+
+    //The shared nodes have two references each so the ref counts have to come out exact for the chain to be freed
+    garray[0] = nullptr;
+    for(size_t i = 0; i < 8 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <set>
+
+struct TypeInfoBase NodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "NodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, &NodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(NodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+void collectPages(NodeValue* node, std::set<PageInfo*>& pages) {
+    if(node == nullptr) {
+        return;
+    }
+
+    pages.insert(PageInfo::extractPageFromPointer(node));
+    collectPages(node->left, pages);
+    collectPages(node->right, pages);
+}
+
+void collectAndSweep() {
+    collect();
+
+#ifdef BSQ_GC_LAZY_SWEEP
+    //Pages are only rebuilt (and their marks cleared) when they are swept
+    for(size_t i = 0; i < BSQ_MAX_ALLOC_SLOTS; i++) {
+        if(gtl_info.g_gcallocs[i] != nullptr) {
+            gtl_info.g_gcallocs[i]->sweepUnsweptPages(SIZE_MAX);
+        }
+    }
+#endif
+}
+
+//Every page a live tree is on has no mark or root bits left -- the whole page (every bitmap word or every live header) and not just the tree objects
+void checkPagesCleared(NodeValue* root) {
+    std::set<PageInfo*> pages;
+    collectPages(root, pages);
+
+    for(PageInfo* p : pages) {
+#ifdef BSQ_GC_MARK_BITMAP
+        assert(p->markwords != 0);
+        for(uint32_t w = 0; w < p->markwords; w++) {
+            assert(p->getMarkBits()[w] == 0);
+            assert(p->getRootBits()[w] == 0);
+        }
+#endif
+
+        for(size_t i = 0; i < p->getBumpIndex(); i++) {
+            MetaData* meta = p->getMetaEntryAtIndex(i);
+#ifdef BSQ_GC_ALLOC_BITMAP
+            //Dead young slots keep their old metadata with the alloc bitmaps
+            if(!p->isSlotInUse(i)) {
+                continue;
+            }
+#endif
+            if(meta->isalloc) {
+                void* obj = (uint8_t*)meta + sizeof(MetaData);
+                assert(!GC_IS_MARKED(obj) && !GC_IS_ROOT(obj));
+            }
+        }
+    }
+}
+
+void* garray[2] = {nullptr, nullptr};
+
+//
+//Roots (the globals) and marked young objects leave no mark or root bits behind once their pages are rebuilt
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&NodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    //A young root is pinned (so it was marked as a root) and the rest of the tree was marked and evacuated
+    NodeValue* t0 = makeTree(10, 0);
+    garray[0] = t0;
+    auto t0_start = printtree(t0);
+
+    collectAndSweep();
+    assert(garray[0] == t0);
+    assert(t0_start == printtree((NodeValue*)garray[0]));
+    checkPagesCleared((NodeValue*)garray[0]);
+
+    //Now an old root next to a young one (the new tree is allocated into the slots freed on the rebuilt pages)
+    garray[1] = makeTree(10, 1);
+    auto t1_start = printtree((NodeValue*)garray[1]);
+
+    collectAndSweep();
+    assert(t0_start == printtree((NodeValue*)garray[0]));
+    assert(t1_start == printtree((NodeValue*)garray[1]));
+    checkPagesCleared((NodeValue*)garray[0]);
+    checkPagesCleared((NodeValue*)garray[1]);
+
+    //Drop the first tree so its pages are rebuilt around the survivors
+    garray[0] = nullptr;
+    collectAndSweep();
+    while(!gtl_info.pending_decs.isEmpty()) {
+        collectAndSweep();
+    }
+
+    assert(t1_start == printtree((NodeValue*)garray[1]));
+    checkPagesCleared((NodeValue*)garray[1]);
+    assert(gtl_info.total_live_bytes == ((1ul << 11) - 1) * NodeType.type_size);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+
+#include <string>
+#include <format>
+
+//exactly a size class
+struct TypeInfoBase SmallNodeType = {
+    .type_id = 1,
+    .type_size = 24,
+    .slot_size = 3,
+    .ptr_mask = "110",
+    .typekey = "SmallNodeType"
+};
+
+//rounds up to the 288 byte class
+struct TypeInfoBase MediumNodeType = {
+    .type_id = 2,
+    .type_size = 264,
+    .slot_size = 33,
+    .ptr_mask = "110000000000000000000000000000000",
+    .typekey = "MediumNodeType"
+};
+
+//rounds up to the 640 byte class
+struct TypeInfoBase LargeNodeType = {
+    .type_id = 3,
+    .type_size = 600,
+    .slot_size = 75,
+    .ptr_mask = "110000000000000000000000000000000000000000000000000000000000000000000000000",
+    .typekey = "LargeNodeType"
+};
+
+struct NodeValue {
+    NodeValue* left;
+    NodeValue* right;
+    int64_t val;
+};
+
+TypeInfoBase* types[3] = { &SmallNodeType, &MediumNodeType, &LargeNodeType };
+
+//No allocators are registered by hand -- everything goes through the size class router
+NodeValue* makeTree(int64_t depth, int64_t val) {
+    if (depth < 0) {
+        return nullptr;
+    }
+
+    NodeValue* n = AllocTypeAuto(NodeValue, types[depth % 3]);
+    n->left = nullptr;
+    n->right = nullptr;
+    n->val = val;
+
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 1);
+
+    return n;
+}
+
+uint64_t treeBytes(NodeValue* node) {
+    if (node == nullptr) {
+        return 0;
+    }
+
+    //live bytes are counted per size class slot
+    uint64_t bytes = getSizeClassBytes(getSizeClassIndex(GC_TYPE(node)->type_size));
+    return bytes + treeBytes(node->left) + treeBytes(node->right);
+}
+
+std::string printtree(NodeValue* node) {
+    if (node == nullptr) {
+        return "null";
+    }
+
+    std::string addr = "xx";
+    std::string nodeStr = "[" + addr + ", " + std::to_string(node->val) + ", " + GC_TYPE(node)->typekey + "]";
+
+    return nodeStr + ", " + printtree(node->left) + ", " + printtree(node->right);
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Tree with nodes from three different size classes (two of which need rounding)
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    REGISTER_TYPE(&SmallNodeType);
+    REGISTER_TYPE(&MediumNodeType);
+    REGISTER_TYPE(&LargeNodeType);
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    assert(isSizeClassBytes(24) && isSizeClassBytes(248) && !isSizeClassBytes(264) && !isSizeClassBytes(600));
+    assert(getSizeClassBytes(getSizeClassIndex(264)) == 288);
+    assert(getSizeClassBytes(getSizeClassIndex(600)) == 640);
+
+    NodeValue* t1 = makeTree(8, 0);
+    garray[0] = t1;
+
+    uint64_t init_total_bytes = treeBytes(t1);
+    auto t1_start = printtree(t1);
+
+    collect();
+    auto t1_end = printtree(t1);
+
+    assert(t1_start == t1_end);
+    assert(init_total_bytes == gtl_info.total_live_bytes);
+
+    garray[0] = nullptr;
+    collect();
+    collect();
+    collect();
+
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "../src/runtime/memory/gc.h"
+#include "../src/runtime/memory/threadinfo.h"
+#include "../src/language/bsqtypelayout.h"
+
+#include <string>
+#include <string.h>
+
+struct TreeNodeValue {
+    TreeNodeValue* left;
+    TreeNodeValue* right;
+    int64_t val;
+};
+
+//Strings are an inline value (length in the low bits) or a pointer to a leaf chunk
+struct StringChunk {
+    int64_t chars[2];
+};
+
+struct NamedNode {
+    NamedNode* next;
+    int64_t id;
+    uintptr_t name;
+};
+
+//Wide enough that its last pointer is past the bitmap slots (and it rounds up to the 576 byte class)
+struct WideNode {
+    WideNode* first;
+    int64_t pad[68];
+    WideNode* last;
+    int64_t val;
+};
+
+struct TypeInfoBase TreeNodeType = BSQTypeLayout<TreeNodeValue, BSQ_PTR_FIELD(TreeNodeValue, left), BSQ_PTR_FIELD(TreeNodeValue, right)>::typeInfo(1, "TreeNodeType");
+struct TypeInfoBase StringChunkType = BSQTypeLayout<StringChunk>::typeInfo(2, "StringChunkType");
+struct TypeInfoBase NamedNodeType = BSQTypeLayout<NamedNode, BSQ_STRING_FIELD(NamedNode, name), BSQ_PTR_FIELD(NamedNode, next)>::typeInfo(3, "NamedNodeType");
+struct TypeInfoBase WideNodeType = BSQTypeLayout<WideNode, BSQ_PTR_FIELD(WideNode, last), BSQ_PTR_FIELD(WideNode, first)>::typeInfo(4, "WideNodeType");
+
+//The derived records have to match what we would have written by hand
+static_assert(BSQTypeLayout<TreeNodeValue, BSQ_PTR_FIELD(TreeNodeValue, left), BSQ_PTR_FIELD(TreeNodeValue, right)>::typeInfo(1, "").type_size == 24);
+static_assert(BSQTypeLayout<NamedNode, BSQ_STRING_FIELD(NamedNode, name), BSQ_PTR_FIELD(NamedNode, next)>::s_ptr_bits == 0x5);
+static_assert(BSQTypeLayout<NamedNode, BSQ_STRING_FIELD(NamedNode, name), BSQ_PTR_FIELD(NamedNode, next)>::s_str_bits == 0x4);
+static_assert(BSQTypeLayout<WideNode, BSQ_PTR_FIELD(WideNode, last), BSQ_PTR_FIELD(WideNode, first)>::s_offsets.entries[1] == (69 << 1));
+
+#define TREE_DEPTH 8
+#define LIST_LENGTH 64
+#define WIDE_LENGTH 16
+
+TreeNodeValue* makeTree(int64_t depth, int64_t val) {
+    if(depth < 0) {
+        return nullptr;
+    }
+
+    TreeNodeValue* n = AllocTypeAuto(TreeNodeValue, &TreeNodeType);
+    n->val = val;
+    n->left = makeTree(depth - 1, val + 1);
+    n->right = makeTree(depth - 1, val + 2);
+
+    return n;
+}
+
+std::string printtree(TreeNodeValue* node) {
+    if(node == nullptr) {
+        return "null";
+    }
+
+    return "[" + std::to_string(node->val) + ", " + printtree(node->left) + ", " + printtree(node->right) + "]";
+}
+
+//Every other node has a heap string (the rest are inline)
+NamedNode* makeList() {
+    NamedNode* head = nullptr;
+    for(int64_t i = 0; i < LIST_LENGTH; i++) {
+        NamedNode* n = AllocTypeAuto(NamedNode, &NamedNodeType);
+        n->next = head;
+        n->id = i;
+        n->name = 0x3;
+
+        if(i % 2 == 0) {
+            StringChunk* s = AllocTypeAuto(StringChunk, &StringChunkType);
+            s->chars[0] = i;
+            s->chars[1] = -i;
+            n->name = (uintptr_t)s;
+        }
+
+        head = n;
+    }
+
+    return head;
+}
+
+std::string printlist(NamedNode* node) {
+    std::string res;
+    while(node != nullptr) {
+        res += std::to_string(node->id);
+        if((node->name & 0x7) == 0) {
+            StringChunk* s = (StringChunk*)node->name;
+            res += "(" + std::to_string(s->chars[0]) + "/" + std::to_string(s->chars[1]) + ")";
+        }
+        res += " ";
+
+        node = node->next;
+    }
+
+    return res;
+}
+
+WideNode* makeWide() {
+    WideNode* head = nullptr;
+    for(int64_t i = 0; i < WIDE_LENGTH; i++) {
+        WideNode* n = AllocTypeAuto(WideNode, &WideNodeType);
+        memset(n->pad, 0, sizeof(n->pad));
+        n->first = nullptr;
+        n->last = head;
+        n->val = i;
+
+        head = n;
+    }
+
+    return head;
+}
+
+std::string printwide(WideNode* node) {
+    std::string res;
+    while(node != nullptr) {
+        res += std::to_string(node->val) + " ";
+        node = node->last;
+    }
+
+    return res;
+}
+
+void* garray[3] = {nullptr, nullptr, nullptr};
+
+//
+//Types derived from their structs at compile time -- bitmap, string, and offset list layouts all have to survive collection and free exactly
+//
+int main(int argc, char** argv) {
+    INIT_LOCKS();
+    GlobalDataStorage::g_global_data.initialize(sizeof(garray), garray);
+
+    InitBSQMemoryTheadLocalInfo();
+    gtl_info.disable_automatic_collections = true;
+    gtl_info.disable_stack_refs_for_tests = true;
+
+    assert(strcmp(TreeNodeType.ptr_mask, "110") == 0);
+    assert(strcmp(NamedNodeType.ptr_mask, "102") == 0);
+    assert(StringChunkType.layout_kind == PTR_LAYOUT_LEAF);
+    assert(WideNodeType.layout_kind == PTR_LAYOUT_OFFSETS && WideNodeType.slot_size == 71);
+
+    garray[0] = makeTree(TREE_DEPTH, 0);
+    garray[1] = makeList();
+    garray[2] = makeWide();
+    auto t0_start = printtree((TreeNodeValue*)garray[0]);
+    auto l1_start = printlist((NamedNode*)garray[1]);
+    auto w2_start = printwide((WideNode*)garray[2]);
+
+    uint64_t tree_bytes = ((1ul << (TREE_DEPTH + 1)) - 1) * TreeNodeType.type_size;
+    uint64_t list_bytes = LIST_LENGTH * NamedNodeType.type_size + (LIST_LENGTH / 2) * StringChunkType.type_size;
+    uint64_t wide_bytes = WIDE_LENGTH * getSizeClassBytes(getSizeClassIndex(WideNodeType.type_size));
+
+    collect();
+
+    assert(t0_start == printtree((TreeNodeValue*)garray[0]));
+    assert(l1_start == printlist((NamedNode*)garray[1]));
+    assert(w2_start == printwide((WideNode*)garray[2]));
+    assert(gtl_info.total_live_bytes == tree_bytes + list_bytes + wide_bytes);
+
+    garray[1] = nullptr;
+    collect();
+    collect();
+
+    assert(t0_start == printtree((TreeNodeValue*)garray[0]));
+    assert(w2_start == printwide((WideNode*)garray[2]));
+    assert(gtl_info.total_live_bytes == tree_bytes + wide_bytes);
+
+    garray[0] = nullptr;
+    garray[2] = nullptr;
+    for(size_t i = 0; i < 8 && gtl_info.total_live_bytes != 0; i++) {
+        collect();
+    }
+    assert(gtl_info.total_live_bytes == 0);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "../src/runtime/common.h"
+
+#include <iostream>
+#include <chrono>
+#include <stdlib.h>
+
+//
+//Times the size specialized copies of xmem.h against the scalar word loop -- and checks that the copy and fill helpers write exactly the words they should.
+//Run the release flavor to see what the specialization buys at -O2 (make BUILD=release test TEST=xmem_kernel_bench).
+//    usage: xmem_kernel_bench [rounds]
+//
+
+#define GUARD_VALUE ((void*)0xBADC0FFEEul)
+
+//Evacuation style copies -- back to back objects of one slot size through a buffer bigger than the L2
+#define COPY_BUFFER_WORDS (4ul * 1024ul * 1024ul / sizeof(void*))
+
+//Read back after every timed loop and printed at the end so the stores are not dropped
+uint64_t g_sink = 0;
+
+//Best of a few timings (the first also warms the caches and the TLB for the buffers)
+template <typename F>
+double measure(size_t rounds, F op) {
+    double best = 0.0;
+    for(size_t k = 0; k < 3; k++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for(size_t i = 0; i < rounds; i++) {
+            op();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count();
+        best = (k == 0 || ms < best) ? ms : best;
+    }
+
+    return best;
+}
+
+void report(const char* name, size_t words, double basems, double kernelms) {
+    std::cout << name << " " << words << " words: scalar " << basems << " ms, kernel " << kernelms << " ms (" << (basems / kernelms) << "x)\n";
+}
+
+//Every length up to a few vector widths with guard words on both sides and every 8 byte offset from a 32 byte boundary
+void checkKernels() {
+    void** src = (void**)aligned_alloc(64, 256 * sizeof(void*));
+    void** trgt = (void**)aligned_alloc(64, 256 * sizeof(void*));
+
+    for(size_t offset = 0; offset < 4; offset++) {
+        for(size_t n = 0; n < 80; n++) {
+            for(size_t i = 0; i < 256; i++) {
+                src[i] = (void*)(i + 1);
+                trgt[i] = GUARD_VALUE;
+            }
+
+            xmem_copy(src + 8 + offset, trgt + 8 + offset, n);
+            for(size_t i = 0; i < 256; i++) {
+                bool inside = (8 + offset <= i && i < 8 + offset + n);
+                assert(trgt[i] == (inside ? src[i] : GUARD_VALUE));
+            }
+
+            xmem_zerofill(trgt + 8 + offset, n);
+            for(size_t i = 0; i < 256; i++) {
+                bool inside = (8 + offset <= i && i < 8 + offset + n);
+                assert(trgt[i] == (inside ? nullptr : GUARD_VALUE));
+            }
+        }
+    }
+
+    free(src);
+    free(trgt);
+
+    void** pages = (void**)aligned_alloc(BSQ_XALLOC_PAGE_SIZE, 3 * BSQ_XALLOC_PAGE_SIZE);
+    size_t pagewords = BSQ_XALLOC_PAGE_SIZE / sizeof(void*);
+    for(size_t i = 0; i < 3 * pagewords; i++) {
+        pages[i] = GUARD_VALUE;
+    }
+
+    xmem_zerofillpage(pages + pagewords);
+    for(size_t i = 0; i < 3 * pagewords; i++) {
+        bool inside = (pagewords <= i && i < 2 * pagewords);
+        assert(pages[i] == (inside ? nullptr : GUARD_VALUE));
+    }
+    free(pages);
+}
+
+//Copy every object of the buffer once -- slot_size words each (copy is a lambda so it is inlined like at the evacuation call sites)
+template <typename F>
+void copyObjects(void** src, void** trgt, size_t slot_size, F copy) {
+    size_t count = COPY_BUFFER_WORDS / slot_size;
+    for(size_t i = 0; i < count; i++) {
+        copy(src + i * slot_size, trgt + i * slot_size, slot_size);
+    }
+    g_sink += (uint64_t)trgt[(count - 1) * slot_size];
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = (argc > 1) ? (size_t)atoi(argv[1]) : 8;
+
+    checkKernels();
+
+    void** src = (void**)aligned_alloc(64, COPY_BUFFER_WORDS * sizeof(void*));
+    void** trgt = (void**)aligned_alloc(64, COPY_BUFFER_WORDS * sizeof(void*));
+    for(size_t i = 0; i < COPY_BUFFER_WORDS; i++) {
+        src[i] = (void*)i;
+        trgt[i] = nullptr;
+    }
+
+    //Slot sizes of the small size classes, a few mid sized ones and the 264 and 600 byte types of the size class tests
+    size_t slot_sizes[] = { 1, 2, 3, 4, 6, 8, 16, 33, 75 };
+    for(size_t slot_size : slot_sizes) {
+        double basems = measure(rounds, [&]() { copyObjects(src, trgt, slot_size, [](void* s, void* t, size_t n) { xmem_copy_scalar(s, t, n); }); });
+        double kernelms = measure(rounds, [&]() { copyObjects(src, trgt, slot_size, [](void* s, void* t, size_t n) { xmem_copy(s, t, n); }); });
+        report("copy", slot_size, basems, kernelms);
+    }
+
+    free(src);
+    free(trgt);
+
+    std::cout << "(checksum " << g_sink << ")\n";
+    return 0;
+}